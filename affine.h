@@ -0,0 +1,188 @@
+#pragma once
+
+// Shard-affine benchmark, selected with --mode=affine, for the sharded
+// implementations (see sharded.h).
+//
+// The keys of all threads are first sorted by the shard they go to. Then
+// every thread works on its own shards only: with fewer threads than shards,
+// thread t takes shards t, t + threads, ...; with more, the threads t, t +
+// shards, ... share shard t and split its keys. Every thread inserts the keys
+// of its shards and then looks them up again. With --pin, the tables of a
+// shard prefer the node of its first thread, see ImplSharded.
+//
+// The thread schedule needs the shards of the implementation, so this runs on
+// the plain implementation: --latency, --memory, --perf and --record do not
+// apply. Threads are pinned as set with --pin.
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "driver.h"
+#include "results.h"
+#include "sharded.h"
+#include "topology.h"
+
+/**
+ * Whether IMPL routes keys to shards, i.e. has shards() and shardOf(key).
+ */
+template<typename IMPL, typename = void>
+struct HasShards: std::false_type {};
+
+template<typename IMPL>
+struct HasShards<IMPL, typename hashtables::make_void<decltype(std::declval<IMPL&>().shardOf(std::declval<typename IMPL::key_type const&>())), decltype(std::declval<IMPL&>().shards())>::type>: std::true_type {};
+
+template<typename TEST, typename IMPL, bool SHARDED = HasShards<IMPL>::value>
+class AffineTest {
+public:
+
+    AffineTest(TEST& test, IMPL& impl)
+    : _test(test)
+    , _impl(impl)
+    {
+    }
+
+    void test() {
+        Settings& settings = Settings::global();
+        size_t bucketScale = settings["buckets_scale"].asUnsignedValue();
+        size_t threads = settings["threads"].asUnsignedValue();
+        size_t inserts = settings["inserts"].asUnsignedValue();
+        _test.setup(bucketScale, threads, inserts, settingAsDouble("duplicateratio", 0.0), settingAsDouble("collisionratio", 1.0));
+
+        _impl.init(bucketScale);
+        size_t shards = _impl.shards();
+        _keysOfShard.assign(shards, {});
+        for(size_t tid = 0; tid < threads; ++tid) {
+            for(size_t i = 0; i < inserts; ++i) {
+                _keysOfShard[_impl.shardOf(_test.key(tid, i))].emplace_back(tid, i);
+            }
+        }
+        size_t largestShard = 0;
+        for(auto const& keys: _keysOfShard) {
+            largestShard = std::max(largestShard, keys.size());
+        }
+
+        auto threadInit = [this](size_t tid) {
+            Topology::get().pin(tid);
+            _impl.thread_init(tid);
+        };
+
+        double insertTime = runThreads(threads, threadInit, [this, threads](size_t tid) {
+            forOwnKeys(tid, threads, [this](size_t t, size_t i) {
+                auto const& k = _test.key(t, i);
+                _impl.insert(k, _test.value(t, i, k));
+            });
+        });
+
+        std::vector<size_t> found(threads * FOUND_STRIDE);
+        double lookupTime = runThreads(threads, threadInit, [this, threads, &found](size_t tid) {
+            size_t hits = 0;
+            forOwnKeys(tid, threads, [this, &hits](size_t t, size_t i) {
+                typename TEST::value_type v;
+                hits += _impl.get(_test.key(t, i), v);
+            });
+            found[tid * FOUND_STRIDE] = hits;
+        });
+
+        _impl.cleanup();
+        _keysOfShard.clear();
+
+        size_t ops = inserts * threads;
+        size_t hits = 0;
+        for(size_t tid = 0; tid < threads; ++tid) {
+            hits += found[tid * FOUND_STRIDE];
+        }
+        double skew = ops ? (double)largestShard * shards / ops : 0.0;
+
+        printHeader();
+        std::cout << std::fixed << std::setw( 25 ) << _impl.name()
+                  << std::fixed << std::setw(  4 ) << bucketScale
+                  << std::fixed << std::setw(  4 ) << threads
+                  << std::fixed << std::setw(  7 ) << shards
+                  << std::fixed << std::setw( 11 ) << ops
+                  << std::fixed << std::setw(  8 ) << std::setprecision(3) << insertTime
+                  << std::fixed << std::setw(  8 ) << std::setprecision(2) << ops / insertTime / 1e6
+                  << std::fixed << std::setw(  8 ) << std::setprecision(3) << lookupTime
+                  << std::fixed << std::setw(  8 ) << std::setprecision(2) << ops / lookupTime / 1e6
+                  << std::fixed << std::setw(  7 ) << std::setprecision(1) << 100.0 * hits / ops
+                  << std::fixed << std::setw(  6 ) << std::setprecision(2) << skew
+                  << std::endl;
+
+        Results& results = Results::get();
+        results.set("time.affine_insert", insertTime);
+        results.set("mops.affine_insert", ops / insertTime / 1e6);
+        results.set("time.affine_lookup", lookupTime);
+        results.set("mops.affine_lookup", ops / lookupTime / 1e6);
+        results.set("hitratio_affine", (double)hits / ops);
+        results.set("shard_skew", skew);
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "scl"
+                  << std::fixed << std::setw(  4 ) << "ths"
+                  << std::fixed << std::setw(  7 ) << "shards"
+                  << std::fixed << std::setw( 11 ) << "inserts"
+                  << std::fixed << std::setw(  8 ) << "ins"
+                  << std::fixed << std::setw(  8 ) << "Mops"
+                  << std::fixed << std::setw(  8 ) << "get"
+                  << std::fixed << std::setw(  8 ) << "Mops"
+                  << std::fixed << std::setw(  7 ) << "found%"
+                  << std::fixed << std::setw(  6 ) << "skew"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    // Keeps the per-thread hit counters on separate cache lines
+    static constexpr size_t FOUND_STRIDE = 64 / sizeof(size_t);
+
+    /**
+     * Calls f(t, i) for the keys thread tid works on, see the top of this
+     * file.
+     */
+    template<typename F>
+    void forOwnKeys(size_t tid, size_t threads, F&& f) {
+        size_t shards = _keysOfShard.size();
+        for(size_t s = tid % shards; s < shards; s += threads) {
+            size_t sharing = threads > shards ? (threads - 1 - s) / shards + 1 : 1;
+            size_t rank = threads > shards ? tid / shards : 0;
+            auto const& keys = _keysOfShard[s];
+            for(size_t j = rank; j < keys.size(); j += sharing) {
+                f(keys[j].first, keys[j].second);
+            }
+        }
+    }
+
+private:
+    TEST& _test;
+    IMPL& _impl;
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> _keysOfShard;
+};
+
+template<typename TEST, typename IMPL>
+class AffineTest<TEST, IMPL, false> {
+public:
+
+    AffineTest(TEST& test, IMPL& impl)
+    : _impl(impl)
+    {
+    }
+
+    void test() {
+        std::cerr << "--mode=affine needs a sharded implementation, " << _impl.name() << " is not" << std::endl;
+    }
+
+private:
+    IMPL& _impl;
+};
@@ -2,7 +2,11 @@
 
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <mutex>
+#include <vector>
 
+#include "mmapper.h"
 #include "tls.h"
 #include <libfrugi/Settings.h>
 
@@ -14,9 +18,13 @@ struct slab {
     char* end;
     slab* next;
 
-    slab(slab* next, size_t bytesNeeded): next(next) {
-        size_t map_page_size = 18 << MAP_HUGE_SHIFT;
-        entries = nextentry = (char*)mmap(nullptr, bytesNeeded, PROT_READ|PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | map_page_size, -1, 0);
+    slab(slab* next, size_t bytesNeeded)
+    : slab(next, bytesNeeded, MMapper::pageMode(), Settings::global()["page_size_scale"].asUnsignedValue())
+    {
+    }
+
+    slab(slab* next, size_t bytesNeeded, MMapper::PageMode pageMode, size_t pageSizePower): next(next) {
+        entries = nextentry = (char*)MMapper::mmapForSlab(bytesNeeded, pageMode, pageSizePower);
         if((intptr_t)entries & 0xFFFF000000000000ULL) {
             std::cout << "Warning: allocated memory slab using upper 16 bits" << std::endl;
         }
@@ -99,17 +107,100 @@ public:
     }
 };
 
+/**
+ * How a SlabManager sizes and maps its slabs. The first slab of a thread
+ * gets initialBytes, every next one of that thread twice the size of the
+ * previous one, up to maxBytes. An allocation that does not fit gets a slab
+ * of its own size. The page settings are looked up when the policy is made,
+ * so linking a slab does not consult the Settings.
+ */
+struct SlabPolicy {
+    size_t initialBytes;
+    size_t maxBytes;
+    MMapper::PageMode pageMode;
+    size_t pageSizePower;
+
+    SlabPolicy(size_t initialBytes, size_t maxBytes)
+    : initialBytes(initialBytes)
+    , maxBytes(std::max(initialBytes, maxBytes))
+    , pageMode(MMapper::pageMode())
+    , pageSizePower(Settings::global()["page_size_scale"].asUnsignedValue())
+    {
+    }
+
+    /**
+     * 64KiB growing to 64MiB.
+     */
+    static SlabPolicy defaults() {
+        return SlabPolicy(1ULL << 16, 1ULL << 26);
+    }
+
+    /**
+     * For a table of 2^bucketsScale buckets: slabs grow up to 4 bytes per
+     * bucket, but no further than the default.
+     */
+    static SlabPolicy forScale(size_t bucketsScale) {
+        SlabPolicy policy = defaults();
+        policy.maxBytes = std::max(policy.initialBytes, std::min<size_t>(policy.maxBytes, 1ULL << (bucketsScale + 2)));
+        return policy;
+    }
+
+    /**
+     * The size of the slab that follows one of lastBytes, or the first one
+     * if lastBytes is 0, such that it fits an allocation of minimumBytes.
+     */
+    size_t nextBytes(size_t lastBytes, size_t minimumBytes) const {
+        size_t bytes = lastBytes ? std::min(maxBytes, lastBytes << 1) : initialBytes;
+        return std::max(bytes, minimumBytes);
+    }
+};
+
+/**
+ * Hands out memory from slabs that belong to this manager. Every thread
+ * allocates from a slab of its own, found in a small thread-local cache of
+ * slabs per manager: a slot is picked by the id of the manager, so up to
+ * THREAD_CACHE_SLOTS managers created after each other never share a slot.
+ * When they do, the manager that takes the slot hands the slab in it back to
+ * its owner as a spare, and the owner continues in that slab, or in another
+ * spare, on its next allocation in a thread that has none cached.
+ *
+ * A thread gets its slab on its first allocation, thread_init() only does
+ * that up front. When a thread exits, its slabs go back to their managers,
+ * and the next thread that needs a slab continues where it left off.
+ */
 class SlabManager {
 public:
 
-    SlabManager()
-    : _allSlabs(nullptr)
+    static constexpr size_t THREAD_CACHE_SLOTS = 1024;
+
+    struct CachedSlab {
+        size_t owner;       // id of the manager, 0 for none
+        slab* current;
+    };
+
+    struct Usage {
+        size_t slabs;
+        size_t reserved;    // bytes mapped for slabs
+        size_t used;        // bytes handed out from them
+    };
+
+    SlabManager(SlabPolicy const& policy = SlabPolicy::defaults())
+    : _policy(policy)
+    , _id(nextId().fetch_add(1, std::memory_order_relaxed))
+    , _allSlabs(nullptr)
     {
 //        std::cout << this << " SlabManager " << inUse() << std::endl;
+        std::lock_guard<std::mutex> lock(registryLock());
+        registry().push_back(this);
     }
 
     ~SlabManager() {
 //        std::cout << this << " ~SlabManager " << inUse() << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(registryLock());
+            auto& managers = registry();
+            managers.erase(std::remove(managers.begin(), managers.end(), this), managers.end());
+        }
         auto current = _allSlabs.load(std::memory_order_relaxed);
         while(current) {
             auto next = current->next;
@@ -121,11 +212,7 @@ public:
     template<typename T>
     __attribute__((always_inline))
     T* alloc() {
-        slab* mySlab = _slab;
-        if(mySlab->nextentry + sizeof(T) > mySlab->end) {
-            mySlab = linkNewSlab(sizeof(T));
-            _slab = mySlab;
-        }
+        slab* mySlab = ensureSlab(sizeof(T));
         auto r = mySlab->alloc<T>();
         assert(r);
         return r;
@@ -134,13 +221,14 @@ public:
     template<typename T>
     __attribute__((always_inline))
     void free(T* mem) {
-        return _slab->free(mem);
+        slab* mySlab = cachedSlab();
+        if(mySlab) mySlab->free(mem);
     }
 
     template<int alignPowerTwo>
     __attribute__((always_inline))
     char* alloc(size_t size) {
-        slab* mySlab = ensureSlab(size);
+        slab* mySlab = ensureSlab(size + alignPowerTwo - 1);
         auto r = mySlab->alloc<alignPowerTwo>(size);
         assert(r);
         return r;
@@ -148,35 +236,65 @@ public:
 
     __attribute__((always_inline))
     void free(void* mem, size_t length) {
-        return _slab->free(mem, length);
+        slab* mySlab = cachedSlab();
+        if(mySlab) mySlab->free(mem, length);
     }
 
     __attribute__((always_inline))
     slab* ensureSlab(size_t size) {
-        slab* mySlab = _slab;
-        if(mySlab == nullptr || mySlab->nextentry + size > mySlab->end) {
+        slab* mySlab = cachedSlab();
+        if(__builtin_expect(mySlab == nullptr || mySlab->nextentry + size > mySlab->end, 0)) {
             slab* oldSlab = mySlab;
             mySlab = linkNewSlab(size);
-            _slab = mySlab;
 //            std::cout << "new slab " << mySlab << ", old slab " << oldSlab << std::endl;
         }
         return mySlab;
     }
 
+    /**
+     * The slab of this manager the calling thread allocates from, or nullptr
+     * if it has none in its cache.
+     */
+    __attribute__((always_inline))
+    slab* cachedSlab() const {
+        CachedSlab& cached = _threadCache[_id & (THREAD_CACHE_SLOTS-1)];
+        return cached.owner == _id ? cached.current : nullptr;
+    }
+
     slab* linkNewSlab(size_t minimum_size) {
         //assert(!_slab.get());
-        Settings& settings = Settings::global();
-        size_t size = 1ULL << (settings["buckets_scale"].asUnsignedValue()+2);
-        auto mySlab = new slab(_allSlabs.load(std::memory_order_relaxed), std::max(size, minimum_size));
-        _slab = mySlab;
+        slab* lastSlab = cachedSlab();
+        if(!lastSlab) {
+            registerThreadExit();
+            slab* spare = takeSpareSlab(minimum_size);
+            if(spare) return cacheSlab(spare);
+        }
+        size_t size = _policy.nextBytes(lastSlab ? lastSlab->end - lastSlab->entries : 0, minimum_size);
+        auto mySlab = new slab(_allSlabs.load(std::memory_order_relaxed), size, _policy.pageMode, _policy.pageSizePower);
+        cacheSlab(mySlab);
         while(!_allSlabs.compare_exchange_weak(mySlab->next, mySlab, std::memory_order_release, std::memory_order_relaxed)) {
         }
         return mySlab;
     }
 
+    /**
+     * Optional: gives the calling thread a slab now instead of on its first
+     * allocation.
+     */
     __attribute__((always_inline))
     void thread_init() {
-        linkNewSlab(0);
+        ensureSlab(0);
+    }
+
+    /**
+     * Rewinds all slabs of this manager so their memory is reused and drops
+     * their pages. Must not run concurrently with allocations.
+     */
+    void reset() {
+        for(slab* s = _allSlabs.load(std::memory_order_relaxed); s; s = s->next) {
+            MMapper::wipe(s->entries, s->nextentry - s->entries);
+            s->nextentry = s->entries;
+        }
     }
 
     __attribute__((always_inline))
@@ -184,10 +302,141 @@ public:
         return _allSlabs != nullptr;
     }
 
+    /**
+     * Adds up the slabs of this manager. Only exact while nobody allocates.
+     */
+    void getUsage(Usage& usage) const {
+        for(slab* s = _allSlabs.load(std::memory_order_acquire); s; s = s->next) {
+            usage.slabs++;
+            usage.reserved += s->end - s->entries;
+            usage.used += s->nextentry - s->entries;
+        }
+    }
+
+    /**
+     * Adds up the slabs of all live managers.
+     */
+    static Usage totalUsage() {
+        Usage usage{0, 0, 0};
+        std::lock_guard<std::mutex> lock(registryLock());
+        for(SlabManager* manager: registry()) {
+            manager->getUsage(usage);
+        }
+        return usage;
+    }
+
+private:
+
+    static std::mutex& registryLock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::vector<SlabManager*>& registry() {
+        static std::vector<SlabManager*> managers;
+        return managers;
+    }
+
+    /**
+     * Ids are never reused, so a slot left behind by a destroyed manager is
+     * never taken for that of a new one at the same address.
+     */
+    static std::atomic<size_t>& nextId() {
+        static std::atomic<size_t> id(1);
+        return id;
+    }
+
+    slab* cacheSlab(slab* mySlab) {
+        CachedSlab& cached = _threadCache[_id & (THREAD_CACHE_SLOTS-1)];
+        if(cached.owner && cached.owner != _id) {
+            evict(cached);
+        }
+        cached.owner = _id;
+        cached.current = mySlab;
+        return mySlab;
+    }
+
+    /**
+     * A slab given back by an exited thread or an evicted cache slot with
+     * room for minimum_size, if there is one.
+     */
+    slab* takeSpareSlab(size_t minimum_size) {
+        std::lock_guard<std::mutex> lock(_spareLock);
+        for(auto it = _spareSlabs.begin(); it != _spareSlabs.end(); ++it) {
+            slab* spare = *it;
+            if(spare->nextentry + minimum_size <= spare->end) {
+                _spareSlabs.erase(it);
+                return spare;
+            }
+        }
+        return nullptr;
+    }
+
+    struct ThreadExit {
+        ~ThreadExit() {
+            releaseThreadSlabs();
+        }
+    };
+
+    /**
+     * Makes sure releaseThreadSlabs() runs when the calling thread exits.
+     */
+    static void registerThreadExit() {
+        static thread_local ThreadExit threadExit;
+        (void)threadExit;
+    }
+
+    /**
+     * Hands the slabs of the calling thread to the managers that are still
+     * alive. The registry lock keeps them from being destroyed meanwhile.
+     */
+    static void releaseThreadSlabs() {
+        std::lock_guard<std::mutex> lock(registryLock());
+        for(SlabManager* manager: registry()) {
+            CachedSlab& cached = _threadCache[manager->_id & (THREAD_CACHE_SLOTS-1)];
+            if(cached.owner != manager->_id) continue;
+            manager->giveBack(cached);
+        }
+    }
+
+    /**
+     * Hands the slab in cached back to the manager that owns it, if that one
+     * is still alive, and empties the slot. A slab of a destroyed manager was
+     * unmapped with it.
+     */
+    static void evict(CachedSlab& cached) {
+        std::lock_guard<std::mutex> lock(registryLock());
+        for(SlabManager* manager: registry()) {
+            if(manager->_id == cached.owner) {
+                manager->giveBack(cached);
+                return;
+            }
+        }
+        cached.owner = 0;
+        cached.current = nullptr;
+    }
+
+    /**
+     * Adds the slab in cached, which is one of ours, to the spares if it has
+     * room left, and empties the slot. Needs the registry lock.
+     */
+    void giveBack(CachedSlab& cached) {
+        if(cached.current->nextentry < cached.current->end) {
+            std::lock_guard<std::mutex> spareLock(_spareLock);
+            _spareSlabs.push_back(cached.current);
+        }
+        cached.owner = 0;
+        cached.current = nullptr;
+    }
+
 private:
 //    static TLS<slab> _slab;
-    static __thread slab* _slab;
+    static __thread CachedSlab _threadCache[THREAD_CACHE_SLOTS];
+    SlabPolicy const _policy;
+    size_t const _id;
     std::atomic<slab*> _allSlabs;
+    std::mutex _spareLock;
+    std::vector<slab*> _spareSlabs;     // slabs of exited threads and evicted slots
 };
 
 template<typename T>
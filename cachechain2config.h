@@ -97,6 +97,7 @@ public:
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask(_entries-1ULL)
+    , _slabManager(SlabPolicy::forScale(bucketsScale))
     {
         _map = (decltype(_map))MMapper::mmapForMap(_buckets * _bucketSize);
     }
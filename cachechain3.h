@@ -12,7 +12,9 @@
 #include <new>
 
 #include "allocator.h"
+#include "casstats.h"
 #include "mmapper.h"
+#include "misspolicy.h"
 #include "murmurhash.h"
 
 #define CACHE_LINE_SIZE_BP2 6
@@ -97,8 +99,11 @@ public:
     }
 };
 
-template<typename K, typename V>
-class HashTable {
+/**
+ * MISSES picks what get() does on a miss, see misspolicy.h.
+ */
+template<typename K, typename V, typename MISSES = hashtables::FastMisses>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
@@ -106,7 +111,7 @@ public:
     using HTE = HashTableEntry<K,V>;
     using BucketHTE = Bucket<HTE>;
 
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_bucketStride)
     , _bucketsMask((_buckets-1ULL))
@@ -132,6 +137,7 @@ public:
         HTE* current = bucket->_entries[e].load(std::memory_order_relaxed);
 
         size_t eOrig = e;
+        CasStats::Op cas;
 
         do {
 
@@ -167,7 +173,7 @@ public:
                         // If it succeeds, we are done: just return the value
                         // If it fails, another thread linked in a new
                         // cachebucket
-                        if(targetEntry.compare_exchange_strong(lastEntry, (HTE*)BucketHTE::makeNext(newBucket), std::memory_order_release, std::memory_order_relaxed)) {
+                        if(cas.strong(targetEntry, lastEntry, (HTE*)BucketHTE::makeNext(newBucket), std::memory_order_release, std::memory_order_relaxed)) {
                             return value;
                         } else {
                             newBucket->clearFromNew(hteWithConfigBits, lastEntry);
@@ -180,7 +186,7 @@ public:
                 }
                 current = bucket->_entries[e].load(std::memory_order_relaxed);
             }
-        } while(!bucket->_entries[e].compare_exchange_weak(current, hteWithConfigBits, std::memory_order_release, std::memory_order_relaxed));
+        } while(!cas.weak(bucket->_entries[e], current, hteWithConfigBits, std::memory_order_release, std::memory_order_relaxed));
         return value;
     }
 
@@ -290,8 +296,11 @@ public:
             current = bucket->_entries[e].load(std::memory_order_relaxed);
         }
         notfound:
-        std::cout << "not found?" << std::endl;
-        return get2(key,value);
+        if(MISSES::diagnose) {
+            std::cout << "not found?" << std::endl;
+            return get2(key,value);
+        }
+        return false;
     }
 
     bool get2(K const& key, V& value) {
@@ -396,7 +405,7 @@ public:
         return _slabManager.free(hte);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -508,4 +517,7 @@ private:
 
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::FastMisses>;
+
 }
@@ -13,6 +13,7 @@
 
 #include "allocator.h"
 #include "mmapper.h"
+#include "misspolicy.h"
 #include "murmurhash.h"
 #include "key_accessor.h"
 
@@ -128,19 +129,23 @@ public:
     }
 };
 
-template<typename K, typename V>
-class HashTable {
+/**
+ * MISSES picks what get() does on a miss, see misspolicy.h.
+ */
+template<typename K, typename V, typename MISSES = hashtables::FastMisses>
+class BasicHashTable {
 public:
 
     using HTE = HashTableEntry<K,V>;
     using BucketHTE = Bucket<HTE>;
 
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_bucketStride)
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask(_entries-1ULL)
+    , _slabManager(SlabPolicy::forScale(bucketsScale))
     {
 
         static_assert(sizeof(HTE) >= 16);
@@ -330,7 +335,10 @@ public:
             current = bucket->_entries[e].load(std::memory_order_relaxed);
         }
         notfound:
-        return get2(key,value);
+        if(MISSES::diagnose) {
+            return get2(key,value);
+        }
+        return false;
     }
 
     bool get2(K const& key, V& value) {
@@ -467,7 +475,7 @@ public:
         return _slabManager.free(mem, size);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -579,4 +587,7 @@ private:
 
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::FastMisses>;
+
 }
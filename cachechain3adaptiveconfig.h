@@ -13,6 +13,7 @@
 
 #include "allocator.h"
 #include "mmapper.h"
+#include "misspolicy.h"
 #include "murmurhash.h"
 
 #define CACHE_LINE_SIZE_BP2 6
@@ -104,8 +105,11 @@ public:
     }
 };
 
-template<typename K, typename V>
-class HashTable {
+/**
+ * MISSES picks what get() does on a miss, see misspolicy.h.
+ */
+template<typename K, typename V, typename MISSES = hashtables::FastMisses>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
@@ -113,7 +117,7 @@ public:
     using HTE = HashTableEntry<K,V>;
     using BucketHTE = Bucket<HTE>;
 
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_bucketStride)
     , _bucketsMask((_buckets-1ULL))
@@ -291,7 +295,10 @@ public:
             current = bucket->_entries[e].load(std::memory_order_relaxed);
         }
         notfound:
-        return get2(key,value);
+        if(MISSES::diagnose) {
+            return get2(key,value);
+        }
+        return false;
     }
 
     bool get2(K const& key, V& value) {
@@ -395,7 +402,7 @@ public:
         return _slabManager.free(hte);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -507,4 +514,7 @@ private:
 
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::FastMisses>;
+
 }
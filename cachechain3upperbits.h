@@ -13,6 +13,7 @@
 
 #include "allocator.h"
 #include "mmapper.h"
+#include "misspolicy.h"
 #include "murmurhash.h"
 
 #define CACHE_LINE_SIZE_BP2 6
@@ -120,8 +121,11 @@ public:
 #  define PREFETCHW(x)		     asm volatile("prefetchw %0" :: "m" (*(unsigned long *)x))
 #  define PREFETCH(x)		     asm volatile("prefetch %0" :: "m" (*(unsigned long *)x))
 
-template<typename K, typename V>
-class HashTable {
+/**
+ * MISSES picks what get() does on a miss, see misspolicy.h.
+ */
+template<typename K, typename V, typename MISSES = hashtables::FastMisses>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
@@ -129,7 +133,7 @@ public:
     using HTE = HashTableEntry<K,V>;
     using BucketHTE = Bucket<HTE>;
 
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_bucketStride)
     , _bucketsMask((_buckets-1ULL))
@@ -318,7 +322,10 @@ public:
             current = bucket->_entries[e].load(std::memory_order_relaxed);
         }
         notfound:
-        return get2(key,value);
+        if(MISSES::diagnose) {
+            return get2(key,value);
+        }
+        return false;
     }
 
     bool get2(K const& key, V& value) {
@@ -449,7 +456,7 @@ public:
         return _slabManager.free(hte);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -560,4 +567,7 @@ private:
 
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::FastMisses>;
+
 }
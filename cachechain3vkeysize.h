@@ -13,6 +13,7 @@
 
 #include "allocator.h"
 #include "mmapper.h"
+#include "misspolicy.h"
 #include "murmurhash.h"
 #include "key_accessor.h"
 
@@ -114,8 +115,11 @@ public:
     }
 };
 
-template<typename K, typename V>
-class HashTable {
+/**
+ * MISSES picks what get() does on a miss, see misspolicy.h.
+ */
+template<typename K, typename V, typename MISSES = hashtables::FastMisses>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 
@@ -124,12 +128,13 @@ public:
     using HTE = HashTableEntry<K,V>;
     using BucketHTE = Bucket<HTE>;
 
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_bucketStride)
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask(_entries-1ULL)
+    , _slabManager(SlabPolicy::forScale(bucketsScale))
     {
 
         static_assert(sizeof(HTE) >= 16);
@@ -315,7 +320,10 @@ public:
             current = bucket->_entries[e].load(std::memory_order_relaxed);
         }
         notfound:
-        return get2(key, value);
+        if(MISSES::diagnose) {
+            return get2(key, value);
+        }
+        return false;
     }
 
     bool get2(K const& key, V& value) {
@@ -432,7 +440,7 @@ public:
         return _slabManager.free(mem, size);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -544,4 +552,7 @@ private:
 
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::FastMisses>;
+
 }
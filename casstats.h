@@ -0,0 +1,109 @@
+#pragma once
+
+// Counters of failed compare-and-swaps in the insert paths of the tables.
+//
+// Only built with -DHT_CAS_STATS (cmake -DWITH_CAS_STATS=ON); otherwise
+// enabled is false, weak() and strong() are plain CASes and totals() stays 0.
+//
+// An insert declares a CasStats::Op and does its CASes through weak() and
+// strong(). A failure counts when another thread changed the slot, not when
+// a weak CAS failed spuriously and left the expected value as it was. Only
+// the failure path does any work: when the insert returns, its failures are
+// added to counters of the calling thread, which are folded into the process
+// totals when the thread exits. Read totals() after joining the benchmark
+// threads and take the difference of two reads.
+
+#include <atomic>
+#include <cstddef>
+
+class CasStats {
+public:
+
+#ifdef HT_CAS_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    struct Totals {
+        size_t failures;    // CASes that failed
+        size_t retried;     // operations with at least one failed CAS
+    };
+
+    class Op {
+    public:
+
+        Op()
+        : _failures(0)
+        {
+        }
+
+        ~Op() {
+            if(enabled && __builtin_expect(_failures != 0, 0)) CasStats::add(_failures);
+        }
+
+        template<typename T, typename D>
+        __attribute__((always_inline))
+        bool weak(std::atomic<T>& slot, T& expected, D const& desired, std::memory_order success, std::memory_order failure) {
+            T seen = expected;
+            bool succeeded = slot.compare_exchange_weak(expected, desired, success, failure);
+            if(enabled) _failures += !succeeded && expected != seen;
+            return succeeded;
+        }
+
+        template<typename T, typename D>
+        __attribute__((always_inline))
+        bool strong(std::atomic<T>& slot, T& expected, D const& desired, std::memory_order success, std::memory_order failure) {
+            bool succeeded = slot.compare_exchange_strong(expected, desired, success, failure);
+            if(enabled) _failures += !succeeded;
+            return succeeded;
+        }
+
+    private:
+        size_t _failures;
+    };
+
+    /**
+     * The counts of all exited threads plus those of the calling thread.
+     */
+    static Totals totals() {
+        Local& local = getLocal();
+        return Totals{global()[FAILURES].load(std::memory_order_relaxed) + local.failures,
+                      global()[RETRIED].load(std::memory_order_relaxed) + local.retried};
+    }
+
+private:
+
+    enum {
+        FAILURES,
+        RETRIED,
+        COUNTERS
+    };
+
+    struct Local {
+        size_t failures = 0;
+        size_t retried = 0;
+
+        ~Local() {
+            global()[FAILURES].fetch_add(failures, std::memory_order_relaxed);
+            global()[RETRIED].fetch_add(retried, std::memory_order_relaxed);
+        }
+    };
+
+    __attribute__((noinline))
+    static void add(size_t failures) {
+        Local& local = getLocal();
+        local.failures += failures;
+        local.retried++;
+    }
+
+    static Local& getLocal() {
+        static thread_local Local local;
+        return local;
+    }
+
+    static std::atomic<size_t>* global() {
+        static std::atomic<size_t> counters[COUNTERS] = {};
+        return counters;
+    }
+};
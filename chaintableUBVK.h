@@ -9,15 +9,15 @@
 
 #include "mmapper.h"
 #include "key_accessor.h"
+#include "key_storage.h"
 
 namespace chaintablegenericUBVK {
 
-template<typename K, typename V>
+template<typename K, typename V, typename KEYS = hashtables::CopiedKeys>
 class HashTableEntry {
 public:
 
-    HashTableEntry(size_t length, const char* keyData, V const& value, HashTableEntry* next): _value(value), _length(length), _next(next) {
-        memmove(_keyData, keyData, length);
+    HashTableEntry(size_t length, const char* keyData, V const& value, HashTableEntry* next): _value(value), _next(next), _key(length, keyData) {
     }
 
     HashTableEntry* getNext() {
@@ -28,70 +28,86 @@ public:
     }
 
     size_t size() const {
-        return sizeof(HashTableEntry) + _length;
+        return sizeof(HashTableEntry) + hashtables::KeyStorage<KEYS>::extraBytes(_key.length());
     }
 
     bool matches(size_t length, const char* keyData) const {
-        if( _length != length) return false;
-        return !memcmp(_keyData, keyData, length);
+        return _key.matches(length, keyData);
     }
 
 public:
     V _value;
-    size_t _length;
     std::atomic<HashTableEntry*> _next;
-    char _keyData[0];
+    hashtables::KeyStorage<KEYS> _key;
 };
 
-template<typename K, typename V>
-class HashTable {
+/**
+ * KEYS selects whether entries hold a copy of the key bytes (CopiedKeys) or
+ * refer to the bytes of the inserted key (ExternalKeys), see key_storage.h.
+ */
+template<typename K, typename V, typename KEYS = hashtables::CopiedKeys>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
 
-    using HTE = HashTableEntry<K,V>;
+    using HTE = HashTableEntry<K,V,KEYS>;
 
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
         : _buckets(1ULL << bucketsScale)
         , _map(nullptr)
+        , _slabManager(SlabPolicy::forScale(bucketsScale))
         {
-        _map = (decltype(_map))MMapper::mmapForMap(_buckets * sizeof(std::atomic<HashTableEntry<K,V>*>));
+        _map = (decltype(_map))MMapper::mmapForMap(_buckets * sizeof(std::atomic<HashTableEntry<K,V,KEYS>*>));
     }
 public:
     V const& insert(K const& key, V const& value) {
+        bool inserted;
+        return findOrInsert(key, value, inserted)->_value;
+    }
+
+    /**
+     * Returns the entry of key, inserting one with value if there is none.
+     * inserted tells whether the returned entry is the one of this call.
+     */
+    HTE* findOrInsert(K const& key, V const& value, bool& inserted) {
 //        printf("key:   %zx\n", key);
         size_t h = hash(key);
         size_t h16l = hash16LeftFromHash(h);
         size_t e = entryFromhash(h);
 //        printf("entry: %zx\n", e);
-        HashTableEntry<K,V>* current = _map[e].load(std::memory_order_relaxed);
+        HashTableEntry<K,V,KEYS>* current = _map[e].load(std::memory_order_relaxed);
 //        printf("cur:   %p\n", current);
 
         const char* keyData = hashtables::key_accessor<K>::data(key);
         size_t length = hashtables::key_accessor<K>::size(key);
 
-        std::atomic<HashTableEntry<K,V>*>* parentLink = &_map[e];
+        std::atomic<HashTableEntry<K,V,KEYS>*>* parentLink = &_map[e];
         while(current) {
 //            printf("checking existing entry: %zx -> %zx\n", current->_key, current->_value);
             size_t currentHash = ((intptr_t)current & 0xFFFF000000000000ULL);
-            current = (HashTableEntry<K,V>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
+            current = (HashTableEntry<K,V,KEYS>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
             if(currentHash == h16l) {
-                if(current->matches(length, keyData)) return current->_value;
+                if(current->matches(length, keyData)) {
+                    inserted = false;
+                    return current;
+                }
             }
             parentLink = &(current->_next);
             current = current->getNext();
         }
 
-        HashTableEntry<K,V>* hte = createHTE(length, keyData, value, nullptr);
-        HashTableEntry<K,V>* hteWithHash = (HashTableEntry<K,V>*)(((intptr_t)hte)|h16l);
+        HashTableEntry<K,V,KEYS>* hte = createHTE(length, keyData, value, nullptr);
+        HashTableEntry<K,V,KEYS>* hteWithHash = (HashTableEntry<K,V,KEYS>*)(((intptr_t)hte)|h16l);
         while(!parentLink->compare_exchange_weak(current, hteWithHash, std::memory_order_release, std::memory_order_relaxed)) {
             while(current) {
                 size_t currentHash = ((intptr_t)current & 0xFFFF000000000000ULL);
-                current = (HashTableEntry<K,V>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
+                current = (HashTableEntry<K,V,KEYS>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
                 if(currentHash == h16l) {
                     if(current->matches(length, keyData)) {
                         //delete hte;
-                        return current->_value;
+                        inserted = false;
+                        return current;
                     }
                 }
                 parentLink = &current->_next;
@@ -102,32 +118,45 @@ public:
 //        printHex(keyData, length);
 //        std::cout << ") -> " << value << ", h=" << h << ", hash16l=" << h16l << std::endl;
 
-        return value;
+        inserted = true;
+        return hte;
     }
 
     bool get(K const& key, V& value) {
+        HashTableEntry<K,V,KEYS>* current = findEntry(key);
+        if(current) {
+            value = current->_value;
+            return true;
+        }
+
+        return get2(key, value);
+    }
+
+    /**
+     * Returns the entry of key, or nullptr if there is none.
+     */
+    HTE* findEntry(K const& key) {
         size_t h = hash(key);
         size_t h16l = hash16LeftFromHash(h);
         size_t e = entryFromhash(h);
 //        printf("entry: %zx\n", e);
-        HashTableEntry<K,V>* current = _map[e].load(std::memory_order_relaxed);
+        HashTableEntry<K,V,KEYS>* current = _map[e].load(std::memory_order_relaxed);
 //        printf("cur:   %p\n", current);
         size_t length = hashtables::key_accessor<K>::size(key);
 
         while(current) {
 //            printf("checking existing entry: %zx -> %zx\n", current->_key, current->_value);
             size_t currentHash = ((intptr_t)current & 0xFFFF000000000000ULL);
-            current = (HashTableEntry<K,V>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
+            current = (HashTableEntry<K,V,KEYS>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
             if(currentHash == h16l) {
                 if(current->matches(length, hashtables::key_accessor<K>::data(key))) {
-                    value = current->_value;
-                    return true;
+                    return current;
                 }
             }
             current = current->getNext();
         }
 
-        return get2(key, value);
+        return nullptr;
     }
 
     void printHex(const char* key, size_t length) {
@@ -140,7 +169,7 @@ public:
         size_t h = hash(key);
         size_t h16l = hash16LeftFromHash(h);
         size_t e = entryFromhash(h);
-        HashTableEntry<K,V>* current = _map[e].load(std::memory_order_relaxed);
+        HashTableEntry<K,V,KEYS>* current = _map[e].load(std::memory_order_relaxed);
 
         const char* keyData = hashtables::key_accessor<K>::data(key);
         size_t length = hashtables::key_accessor<K>::size(key);
@@ -155,10 +184,10 @@ public:
         while(current) {
             size_t currentHash = ((intptr_t)current & 0xFFFF000000000000ULL);
             std::cout << "Checking entry " << current << ", hash " << currentHash << std::endl;
-            current = (HashTableEntry<K,V>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
+            current = (HashTableEntry<K,V,KEYS>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
             if(currentHash == h16l) {
                 std::cout << "  Key/Value: (";
-                printHex(current->_keyData, current->_length);
+                printHex(current->_key.data(), current->_key.length());
                 std::cout << ") -> " << current->_value << std::endl;
                 if(current->matches(length, keyData)) {
                     value = current->_value;
@@ -186,12 +215,12 @@ public:
         return MurmurHash64(key);
     }
 
-    size_t bucketSize(std::atomic<HashTableEntry<K,V>*>* bucket) {
+    size_t bucketSize(std::atomic<HashTableEntry<K,V,KEYS>*>* bucket) {
         size_t s = 0;
-        HashTableEntry<K,V>* current = bucket->load(std::memory_order_relaxed);
+        HashTableEntry<K,V,KEYS>* current = bucket->load(std::memory_order_relaxed);
         while(current) {
             s++;
-            current = (HashTableEntry<K,V>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
+            current = (HashTableEntry<K,V,KEYS>*)((intptr_t)current & 0x0000FFFFFFFFFFFFULL);
             current = current->getNext();
         }
         return s;
@@ -199,8 +228,8 @@ public:
 
     size_t size() {
         size_t s = 0;
-        std::atomic<HashTableEntry<K,V>*>* bucket = _map;
-        std::atomic<HashTableEntry<K,V>*>* end = _map + _buckets;
+        std::atomic<HashTableEntry<K,V,KEYS>*>* bucket = _map;
+        std::atomic<HashTableEntry<K,V,KEYS>*>* end = _map + _buckets;
         while(bucket < end) {
             s += bucketSize(bucket);
             bucket++;
@@ -217,8 +246,8 @@ public:
         _slabManager.thread_init();
     }
 
-    HashTableEntry<K,V>* createHTE(size_t length, const char* keyData, V const& value, HashTableEntry<K,V>* next) {
-        HTE* hte = new(_slabManager.alloc<4>(sizeof(HTE) + length)) HTE(length, keyData, value, next);
+    HashTableEntry<K,V,KEYS>* createHTE(size_t length, const char* keyData, V const& value, HashTableEntry<K,V,KEYS>* next) {
+        HTE* hte = new(_slabManager.alloc<4>(sizeof(HTE) + hashtables::KeyStorage<KEYS>::extraBytes(length))) HTE(length, keyData, value, next);
         assert( (((intptr_t)hte)&0x3) == 0);
         return hte;
     }
@@ -228,8 +257,8 @@ public:
         return _slabManager.free(hte);
     }
 
-    ~HashTable() {
-        munmap(_map, _buckets * sizeof(std::atomic<HashTableEntry<K,V>*>));
+    ~BasicHashTable() {
+        munmap(_map, _buckets * sizeof(std::atomic<HashTableEntry<K,V,KEYS>*>));
     }
 
     struct stats {
@@ -248,13 +277,13 @@ public:
         s.avgChainLength = 0.0;
 
         for(size_t idx = 0; idx < _buckets; ++idx) {
-            HashTableEntry<K,V>* bucket = _map[idx].load(std::memory_order_relaxed);
+            HashTableEntry<K,V,KEYS>* bucket = _map[idx].load(std::memory_order_relaxed);
             if(bucket) {
-                HashTableEntry<K,V>* entry = bucket;
+                HashTableEntry<K,V,KEYS>* entry = bucket;
                 size_t chainSize = 0;
                 while(entry) {
                     chainSize++;
-                    entry = (HashTableEntry<K,V>*)((intptr_t)entry & 0x0000FFFFFFFFFFFFULL);
+                    entry = (HashTableEntry<K,V,KEYS>*)((intptr_t)entry & 0x0000FFFFFFFFFFFFULL);
                     entry = entry->_next.load(std::memory_order_relaxed);
                 }
                 s.usedBuckets++;
@@ -279,13 +308,13 @@ public:
             size_t max = std::min(_buckets, idx + bucketPerBar);
             for(; idx < max; ++idx) {
 
-                HashTableEntry<K,V>* bucket = _map[idx].load(std::memory_order_relaxed);
+                HashTableEntry<K,V,KEYS>* bucket = _map[idx].load(std::memory_order_relaxed);
                 if(bucket) {
-                    HashTableEntry<K,V>* entry = bucket;
+                    HashTableEntry<K,V,KEYS>* entry = bucket;
                     size_t chainSize = 0;
                     while(entry) {
                         chainSize++;
-                        entry = (HashTableEntry<K,V>*)((intptr_t)entry & 0x0000FFFFFFFFFFFFULL);
+                        entry = (HashTableEntry<K,V,KEYS>*)((intptr_t)entry & 0x0000FFFFFFFFFFFFULL);
                         entry = entry->_next.load(std::memory_order_relaxed);
                     }
                     elementsInThisBar += chainSize;
@@ -298,9 +327,15 @@ public:
 
 private:
     size_t _buckets;
-    std::atomic<HashTableEntry<K,V>*>* _map;
+    std::atomic<HashTableEntry<K,V,KEYS>*>* _map;
 
     SlabManager _slabManager;
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::CopiedKeys>;
+
+template<typename K, typename V>
+using ExternalKeyHashTable = BasicHashTable<K, V, hashtables::ExternalKeys>;
+
 }
@@ -8,39 +8,11 @@
 #include <atomic>
 #include <new>
 
+#include "allocator.h"
 #include "mmapper.h"
 
 namespace chaintablegeneric {
 
-template<typename HTE>
-struct slab {
-    HTE* entries;
-    HTE* nextentry;
-    HTE* end;
-    slab* next;
-
-    slab(slab* next): next(next) {
-        size_t bytesNeeded = sizeof(HTE) << 29;
-        size_t map_page_size = 18 << MAP_HUGE_SHIFT;
-        entries = nextentry = (HTE*)mmap(nullptr, bytesNeeded, PROT_READ|PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | map_page_size, -1, 0);
-        end = entries + bytesNeeded/sizeof(HTE);
-        //printf("entries @ %p: %zu bytes, %zu entries\n", (void*)entries, bytesNeeded, bytesNeeded/sizeof(HTE));
-        assert(entries);
-    }
-
-    ~slab() {
-        //printf("unmapped entries @ %p\n", (void*)entries);
-        munmap(entries, (end-entries)*sizeof(HTE));
-    }
-
-    HTE* create() {
-        return nextentry++;
-    }
-    void free(HTE* hte) {
-        nextentry--;
-    }
-};
-
 template<typename K, typename V>
 class HashTableEntry {
 public:
@@ -67,7 +39,7 @@ public:
     HashTable(size_t bucketsScale)
         : _buckets(1ULL << bucketsScale)
         , _map(nullptr)
-        , _allSlabs(nullptr)
+        , _slabManager(SlabPolicy::forScale(bucketsScale))
         {
         _map = (decltype(_map))MMapper::mmapForMap(_buckets * sizeof(std::atomic<HashTableEntry<K,V>*>));
     }
@@ -154,30 +126,20 @@ public:
     }
 
     void thread_init() {
-        assert(!_slab);
-        _slab = new slab<HashTableEntry<K,V>>(_allSlabs.load(std::memory_order_relaxed));
-        while(!_allSlabs.compare_exchange_weak(_slab->next, _slab, std::memory_order_release, std::memory_order_relaxed)) {
-        }
+        _slabManager.thread_init();
     }
 
-    static HashTableEntry<K,V>* createHTE(K const& key, V const& value, HashTableEntry<K,V>* next) {
-        assert(_slab);
-        assert(_slab->nextentry < _slab->end);
-        return new(_slab->create()) HashTableEntry<K,V>(key, value, next);
+    HashTableEntry<K,V>* createHTE(K const& key, V const& value, HashTableEntry<K,V>* next) {
+        return new(_slabManager.alloc<alignof(HashTableEntry<K,V>)>(sizeof(HashTableEntry<K,V>))) HashTableEntry<K,V>(key, value, next);
     }
 
     template<typename T>
     void giveMemoryBack(T* const& hte) {
-        return _slab->free(hte);
+        return _slabManager.free(hte);
     }
 
     ~HashTable() {
-        auto current = _allSlabs.load(std::memory_order_relaxed);
-        while(current) {
-            auto next = current->next;
-            delete current;
-            current = next;
-        }
+        munmap(_map, _buckets * sizeof(std::atomic<HashTableEntry<K,V>*>));
     }
 
     struct stats {
@@ -245,12 +207,8 @@ public:
 private:
     size_t _buckets;
     std::atomic<HashTableEntry<K,V>*>* _map;
-    std::atomic<slab<HashTableEntry<K,V>>*> _allSlabs;
 
-    static __thread slab<HashTableEntry<K,V>>* _slab;
+    SlabManager _slabManager;
 };
 
-template<typename K, typename V>
-__thread slab<HashTableEntry<K,V>>* HashTable<K,V>::_slab;
-
 }
@@ -38,7 +38,7 @@ class HashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
-    HashTable(size_t bucketsScale): _buckets(1ULL << bucketsScale) {
+    HashTable(size_t bucketsScale): _slabManager(SlabPolicy::forScale(bucketsScale)), _buckets(1ULL << bucketsScale) {
         _map = (decltype(_map))MMapper::mmapForMap(_buckets * sizeof(std::atomic<HashTableEntry*>));
     }
 public:
@@ -0,0 +1,416 @@
+#pragma once
+
+// chaintableUBVK that grows by linear hashing over split-ordered lists, in
+// the style of Shalev and Shavit and of split_list_map in libcds.
+//
+// All entries are in one linked list, sorted by the bit-reversed hash. A
+// bucket is a pointer to a dummy node in that list, and the entries of bucket
+// b = h & (buckets - 1) follow its dummy node. The table grows by doubling
+// the number of buckets, which only changes a counter: a new bucket is
+// initialised on its first insert by linking a dummy node into the chain of
+// its parent (b without its top bit), which splits that chain in two without
+// moving any entry. So buckets split one at a time, and only the thread that
+// first inserts into a bucket pays for it.
+//
+// Dummy nodes have an even order, the bit-reversed bucket, entries an odd
+// one, the bit-reversed hash with its lowest bit set, so a dummy node sorts
+// in front of the entries of its bucket. Entries are only ever inserted,
+// with one CAS, so nothing needs to be marked. Lookups never write and never
+// wait: they start at the closest initialised bucket of the parent chain.
+//
+// The table grows when the inserts, counted on a 1/16 sample of the keys,
+// pass --grow_load (default 1.0) entries per bucket, so chains stay at one or
+// two entries. The bucket array is a list of segments, mapped on demand and
+// never moved: segment 0 holds the 2^bucketsScale initial buckets, segment
+// i > 0 the next 2^(bucketsScale + i - 1).
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <string>
+
+#include "allocator.h"
+#include "mmapper.h"
+#include "murmurhash.h"
+#include "key_accessor.h"
+#include "key_storage.h"
+
+namespace chaintablesplitUBVK {
+
+/**
+ * A node of the split-ordered list, a dummy node on its own.
+ */
+class Node {
+public:
+
+    Node(size_t order, Node* next): _next(next), _order(order) {
+    }
+
+    Node* getNext() {
+        return _next.load(std::memory_order_acquire);
+    }
+
+    bool isDummy() const {
+        return !(_order & 1);
+    }
+
+public:
+    std::atomic<Node*> _next;
+    size_t const _order;
+};
+
+template<typename K, typename V, typename KEYS = hashtables::CopiedKeys>
+class HashTableEntry: public Node {
+public:
+
+    HashTableEntry(size_t order, size_t length, const char* keyData, V const& value, Node* next): Node(order, next), _value(value), _key(length, keyData) {
+    }
+
+    size_t size() const {
+        return sizeof(HashTableEntry) + hashtables::KeyStorage<KEYS>::extraBytes(_key.length());
+    }
+
+    bool matches(size_t length, const char* keyData) const {
+        return _key.matches(length, keyData);
+    }
+
+public:
+    V _value;
+    hashtables::KeyStorage<KEYS> _key;
+};
+
+/**
+ * KEYS selects whether entries hold a copy of the key bytes (CopiedKeys) or
+ * refer to the bytes of the inserted key (ExternalKeys), see key_storage.h.
+ */
+template<typename K, typename V, typename KEYS = hashtables::CopiedKeys>
+class BasicHashTable {
+public:
+
+    using HTE = HashTableEntry<K,V,KEYS>;
+
+    static constexpr size_t MAX_SEGMENTS = 40;
+    static constexpr size_t SAMPLE_BITS = 4;
+
+    BasicHashTable(size_t bucketsScale)
+    : _firstScale(bucketsScale)
+    , _maxBuckets(1ULL << std::min<size_t>(bucketsScale + MAX_SEGMENTS - 1, 48))
+    , _maxLoad(maxLoadFromSettings())
+    , _buckets(1ULL << bucketsScale)
+    , _sampledInserts(0)
+    , _slabManager(SlabPolicy::forScale(bucketsScale))
+    {
+        for(auto& segment: _segments) {
+            segment.store(nullptr, std::memory_order_relaxed);
+        }
+        _segments[0].store(mapSegment(0), std::memory_order_relaxed);
+        _head = new(_slabManager.alloc<4>(sizeof(Node))) Node(0, nullptr);
+        _segments[0].load(std::memory_order_relaxed)[0].store(_head, std::memory_order_release);
+    }
+
+    BasicHashTable(BasicHashTable const&) = delete;
+    BasicHashTable& operator=(BasicHashTable const&) = delete;
+
+    ~BasicHashTable() {
+        for(size_t i = 0; i < MAX_SEGMENTS; ++i) {
+            std::atomic<Node*>* segment = _segments[i].load(std::memory_order_relaxed);
+            if(segment) MMapper::munmap(segment, segmentBytes(i));
+        }
+    }
+
+    V const& insert(K const& key, V const& value) {
+        bool inserted;
+        return findOrInsert(key, value, inserted)->_value;
+    }
+
+    /**
+     * Returns the entry of key, inserting one with value if there is none.
+     * inserted tells whether the returned entry is the one of this call.
+     */
+    HTE* findOrInsert(K const& key, V const& value, bool& inserted) {
+        size_t h = hash(key);
+        size_t order = regularOrder(h);
+        const char* keyData = hashtables::key_accessor<K>::data(key);
+        size_t length = hashtables::key_accessor<K>::size(key);
+
+        std::atomic<Node*>* parentLink = &bucketNode(h & (_buckets.load(std::memory_order_acquire) - 1))->_next;
+        Node* current = parentLink->load(std::memory_order_acquire);
+        HTE* hte = nullptr;
+        while(true) {
+            while(current && current->_order < order) {
+                parentLink = &current->_next;
+                current = current->getNext();
+            }
+            while(current && current->_order == order) {
+                if(((HTE*)current)->matches(length, keyData)) {
+                    if(hte) _slabManager.free(hte, hte->size());
+                    inserted = false;
+                    return (HTE*)current;
+                }
+                parentLink = &current->_next;
+                current = current->getNext();
+            }
+            if(!hte) {
+                hte = new(_slabManager.alloc<4>(sizeof(HTE) + hashtables::KeyStorage<KEYS>::extraBytes(length))) HTE(order, length, keyData, value, current);
+            } else {
+                hte->_next.store(current, std::memory_order_relaxed);
+            }
+            if(parentLink->compare_exchange_weak(current, hte, std::memory_order_release, std::memory_order_acquire)) break;
+        }
+
+        if(count(h)) grow();
+        inserted = true;
+        return hte;
+    }
+
+    bool get(K const& key, V& value) {
+        HTE* current = findEntry(key);
+        if(current) {
+            value = current->_value;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Returns the entry of key, or nullptr if there is none.
+     */
+    HTE* findEntry(K const& key) {
+        size_t h = hash(key);
+        size_t order = regularOrder(h);
+        size_t length = hashtables::key_accessor<K>::size(key);
+
+        Node* current = initialisedAncestor(h & (_buckets.load(std::memory_order_acquire) - 1));
+        while(current && current->_order < order) {
+            current = current->getNext();
+        }
+        while(current && current->_order == order) {
+            if(((HTE*)current)->matches(length, hashtables::key_accessor<K>::data(key))) {
+                return (HTE*)current;
+            }
+            current = current->getNext();
+        }
+        return nullptr;
+    }
+
+    size_t hash(K const& key) {
+        return MurmurHash64(key);
+    }
+
+    static size_t reverse(size_t x) {
+        x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+        x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+        x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        return __builtin_bswap64(x);
+    }
+
+    static size_t regularOrder(size_t h) {
+        return reverse(h) | 1ULL;
+    }
+
+    static size_t dummyOrder(size_t bucket) {
+        return reverse(bucket);
+    }
+
+    size_t buckets() const {
+        return _buckets.load(std::memory_order_acquire);
+    }
+
+    size_t bucketsScale() const {
+        return __builtin_ctzll(buckets());
+    }
+
+    void thread_init() {
+        _slabManager.thread_init();
+    }
+
+    struct stats {
+        size_t size;
+        size_t usedBuckets;
+        size_t collisions;
+        size_t longestChain;
+        double avgChainLength;
+    };
+
+    /**
+     * Walks the list once. A chain runs from a dummy node to the next one,
+     * so a bucket that is not initialised yet counts with its parent.
+     */
+    void getStats(stats& s) {
+        s.size = 0;
+        s.usedBuckets = 0;
+        s.collisions = 0;
+        s.longestChain = 0;
+        s.avgChainLength = 0.0;
+
+        Node* current = _head;
+        while(current) {
+            size_t chainSize = 0;
+            current = current->getNext();
+            while(current && !current->isDummy()) {
+                chainSize++;
+                current = current->getNext();
+            }
+            if(chainSize > 0) {
+                s.usedBuckets++;
+                s.size += chainSize;
+                s.collisions += chainSize - 1;
+                if(chainSize > s.longestChain) s.longestChain = chainSize;
+            }
+        }
+        size_t b = buckets();
+        if(b > 0) {
+            s.avgChainLength = (double)s.size / (double)b;
+        }
+    }
+
+private:
+
+    static double maxLoadFromSettings() {
+        std::string load = Settings::global()["grow_load"].asString();
+        return load.empty() ? 1.0 : std::stod(load);
+    }
+
+    size_t segmentOf(size_t bucket) const {
+        if(bucket < (1ULL << _firstScale)) return 0;
+        return 63 - __builtin_clzll(bucket) - _firstScale + 1;
+    }
+
+    size_t segmentStart(size_t segment) const {
+        return segment ? 1ULL << (_firstScale + segment - 1) : 0;
+    }
+
+    size_t segmentBytes(size_t segment) const {
+        return (segment ? 1ULL << (_firstScale + segment - 1) : 1ULL << _firstScale) * sizeof(std::atomic<Node*>);
+    }
+
+    std::atomic<Node*>* mapSegment(size_t segment) {
+        return (std::atomic<Node*>*)MMapper::mmapForMap(segmentBytes(segment));
+    }
+
+    /**
+     * The slot of bucket, mapping its segment if nobody did yet.
+     */
+    std::atomic<Node*>& bucketSlot(size_t bucket) {
+        size_t s = segmentOf(bucket);
+        std::atomic<Node*>* segment = _segments[s].load(std::memory_order_acquire);
+        if(__builtin_expect(!segment, 0)) {
+            std::atomic<Node*>* mapped = mapSegment(s);
+            if(_segments[s].compare_exchange_strong(segment, mapped, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                segment = mapped;
+            } else {
+                MMapper::munmap(mapped, segmentBytes(s));
+            }
+        }
+        return segment[bucket - segmentStart(s)];
+    }
+
+    /**
+     * The dummy node of bucket, linking it in first if need be.
+     */
+    __attribute__((always_inline))
+    Node* bucketNode(size_t bucket) {
+        Node* node = bucketSlot(bucket).load(std::memory_order_acquire);
+        return node ? node : initialiseBucket(bucket);
+    }
+
+    /**
+     * Links the dummy node of bucket into the chain of its parent, which
+     * initialises the parent first if need be. If another thread linked it
+     * first, that node is the one.
+     */
+    __attribute__((noinline))
+    Node* initialiseBucket(size_t bucket) {
+        size_t parent = bucket & ~(1ULL << (63 - __builtin_clzll(bucket)));
+        size_t order = dummyOrder(bucket);
+
+        std::atomic<Node*>* parentLink = &bucketNode(parent)->_next;
+        Node* current = parentLink->load(std::memory_order_acquire);
+        Node* dummy = nullptr;
+        while(true) {
+            while(current && current->_order < order) {
+                parentLink = &current->_next;
+                current = current->getNext();
+            }
+            if(current && current->_order == order) {
+                if(dummy) _slabManager.free(dummy, sizeof(Node));
+                dummy = current;
+                break;
+            }
+            if(!dummy) {
+                dummy = new(_slabManager.alloc<4>(sizeof(Node))) Node(order, current);
+            } else {
+                dummy->_next.store(current, std::memory_order_relaxed);
+            }
+            if(parentLink->compare_exchange_weak(current, dummy, std::memory_order_release, std::memory_order_acquire)) break;
+        }
+        bucketSlot(bucket).store(dummy, std::memory_order_release);
+        return dummy;
+    }
+
+    /**
+     * The dummy node of bucket or of its closest initialised parent. Does
+     * not write, so lookups do not map segments or link dummy nodes.
+     */
+    Node* initialisedAncestor(size_t bucket) {
+        while(bucket) {
+            size_t s = segmentOf(bucket);
+            std::atomic<Node*>* segment = _segments[s].load(std::memory_order_acquire);
+            if(segment) {
+                Node* node = segment[bucket - segmentStart(s)].load(std::memory_order_acquire);
+                if(node) return node;
+            }
+            bucket &= ~(1ULL << (63 - __builtin_clzll(bucket)));
+        }
+        return _head;
+    }
+
+    /**
+     * Counts an insert if h is in the sample. Returns whether the table is
+     * over its load.
+     */
+    __attribute__((always_inline))
+    bool count(size_t h) {
+        // Mixed first: MurmurHash64 of an integer is the integer itself
+        if((h * 0x9E3779B97F4A7C15ULL) >> (64 - SAMPLE_BITS)) return false;
+        size_t n = _sampledInserts.fetch_add(1, std::memory_order_relaxed) + 1;
+        return (n << SAMPLE_BITS) > _buckets.load(std::memory_order_relaxed) * _maxLoad;
+    }
+
+    /**
+     * Doubles the buckets unless another thread already did. The new
+     * buckets are initialised one by one as inserts reach them.
+     */
+    void grow() {
+        size_t buckets = _buckets.load(std::memory_order_relaxed);
+        if(buckets < _maxBuckets) {
+            _buckets.compare_exchange_strong(buckets, buckets * 2, std::memory_order_acq_rel, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    size_t const _firstScale;
+    size_t const _maxBuckets;
+    double const _maxLoad;
+    std::atomic<std::atomic<Node*>*> _segments[MAX_SEGMENTS];
+    Node* _head;
+
+    // Written while the table is in use, so kept off the lines above
+    char _padding0[64];
+    std::atomic<size_t> _buckets;
+    char _padding1[64];
+    std::atomic<size_t> _sampledInserts;
+    char _padding2[64];
+
+    SlabManager _slabManager;
+};
+
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::CopiedKeys>;
+
+template<typename K, typename V>
+using ExternalKeyHashTable = BasicHashTable<K, V, hashtables::ExternalKeys>;
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+// Hot-key contention benchmark, selected with --mode=contention.
+//
+// All threads insert the same sequence of --operations keys (default
+// --inserts), taken from the test data, in blocks of K keys: within a block
+// every thread starts at a different key and wraps around, so at any time the
+// threads race to insert the same K fresh keys into the same few buckets.
+// K is swept over --contended_keys=1,8,64,512,4096 (the default), each on a
+// fresh table. Besides the throughput, every row shows the CASes that failed
+// in the insert paths (per insert, see casstats.h) and the share of inserts
+// that had to retry at least once. Tables without CAS counters show 0, and
+// so do all tables unless the counters are built in, see casstats.h.
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "casstats.h"
+#include "driver.h"
+#include "results.h"
+
+template<typename TEST, typename IMPL>
+class ContentionTest {
+public:
+
+    ContentionTest(TEST& test, IMPL& impl)
+    : _test(test)
+    , _impl(impl)
+    {
+    }
+
+    void test() {
+        Settings& settings = Settings::global();
+        size_t bucketScale = settings["buckets_scale"].asUnsignedValue();
+        size_t threads = settings["threads"].asUnsignedValue();
+        size_t inserts = settings["inserts"].asUnsignedValue();
+        size_t operations = std::min(settingAsUnsigned("operations", inserts), inserts * threads);
+        _test.setup(bucketScale, threads, inserts, settingAsDouble("duplicateratio", 0.0), settingAsDouble("collisionratio", 1.0));
+
+        for(size_t hotKeys: contendedKeys()) {
+            hotKeys = std::max<size_t>(1, std::min(hotKeys, operations));
+            _impl.init(bucketScale);
+            CasStats::Totals before = CasStats::totals();
+            double time = runThreads(threads, [this](size_t tid) { _impl.thread_init(tid); }, [this, threads, operations, hotKeys](size_t tid) {
+                run(tid, threads, operations, hotKeys);
+            });
+            CasStats::Totals after = CasStats::totals();
+            std::string label = "hot " + std::to_string(hotKeys);
+            endPhase(_impl, label);
+            _impl.cleanup();
+
+            size_t ops = operations * threads;
+            size_t failures = after.failures - before.failures;
+            size_t retried = after.retried - before.retried;
+
+            printHeader();
+            std::cout << std::fixed << std::setw( 25 ) << _impl.name()
+                      << std::fixed << std::setw(  4 ) << bucketScale
+                      << std::fixed << std::setw(  4 ) << threads
+                      << std::fixed << std::setw(  8 ) << hotKeys
+                      << std::fixed << std::setw( 11 ) << ops
+                      << std::fixed << std::setw(  8 ) << std::setprecision(3) << time
+                      << std::fixed << std::setw(  8 ) << std::setprecision(2) << ops / time / 1e6
+                      << std::fixed << std::setw( 11 ) << failures
+                      << std::fixed << std::setw(  9 ) << std::setprecision(4) << (double)failures / ops
+                      << std::fixed << std::setw(  9 ) << std::setprecision(2) << 100.0 * retried / ops
+                      << std::endl;
+
+            Results& results = Results::get();
+            std::string metric = Results::metricName(label);
+            results.set("time." + metric, time);
+            results.set("mops." + metric, ops / time / 1e6);
+            if(CasStats::enabled) {
+                results.set("cas." + metric + ".failures", failures);
+                results.set("cas." + metric + ".retried", retried);
+            }
+        }
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        if(!CasStats::enabled) {
+            std::cout << "CAS failures are not counted in this build, configure with -DWITH_CAS_STATS=ON" << std::endl;
+        }
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "scl"
+                  << std::fixed << std::setw(  4 ) << "ths"
+                  << std::fixed << std::setw(  8 ) << "hot"
+                  << std::fixed << std::setw( 11 ) << "inserts"
+                  << std::fixed << std::setw(  8 ) << "time"
+                  << std::fixed << std::setw(  8 ) << "Mops"
+                  << std::fixed << std::setw( 11 ) << "casfail"
+                  << std::fixed << std::setw(  9 ) << "fail/op"
+                  << std::fixed << std::setw(  9 ) << "retry%"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    static std::vector<size_t> contendedKeys() {
+        std::string list = Settings::global()["contended_keys"].asString();
+        if(list.empty()) list = "1,8,64,512,4096";
+        std::vector<size_t> keys;
+        std::stringstream s(list);
+        std::string k;
+        while(std::getline(s, k, ',')) {
+            if(!k.empty()) keys.push_back(std::stoull(k));
+        }
+        return keys;
+    }
+
+    /**
+     * The n-th key of the shared sequence. The test data is laid out per
+     * thread, so the sequence interleaves the threads' keys.
+     */
+    __attribute__((always_inline))
+    decltype(auto) keyAt(size_t n, size_t threads) {
+        return _test.key(n % threads, n / threads);
+    }
+
+    void run(size_t tid, size_t threads, size_t operations, size_t hotKeys) {
+        for(size_t block = 0; block < operations; block += hotKeys) {
+            size_t size = std::min(hotKeys, operations - block);
+            size_t offset = tid % size;
+            for(size_t i = 0; i < size; ++i) {
+                size_t n = block + (offset + i) % size;
+                auto const& k = keyAt(n, threads);
+                _impl.insert(k, _test.value(n % threads, n / threads, k));
+            }
+        }
+    }
+
+private:
+    TEST& _test;
+    IMPL& _impl;
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+// Shared pieces for the benchmark drivers next to the simple one:
+// a deterministic per-thread random generator, a Zipfian generator and a
+// helper that runs a phase on a number of threads and times it.
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include <xmmintrin.h>
+
+#include "common/timer.h"
+
+#include <libfrugi/Settings.h>
+
+using namespace libfrugi;
+
+/**
+ * Small, fast generator (splitmix64) so an operation stream only depends on
+ * its seed, never on the table under test.
+ */
+class Random {
+public:
+    Random(uint64_t seed): _state(seed) {
+    }
+
+    __attribute__((always_inline))
+    uint64_t next() {
+        uint64_t z = (_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    __attribute__((always_inline))
+    double nextDouble() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    __attribute__((always_inline))
+    size_t nextBelow(size_t n) {
+        return n ? next() % n : 0;
+    }
+
+    static uint64_t seedFor(uint64_t seed, size_t tid) {
+        return seed * 0x100000001B3ULL + tid + 1;
+    }
+
+private:
+    uint64_t _state;
+};
+
+/**
+ * Zipfian distribution over [0, items), rank 0 being the most popular, as in
+ * Gray et al., "Quickly Generating Billion-Record Synthetic Databases" (and
+ * YCSB). Construction computes zeta(items) with the given number of threads.
+ * theta must be below 1: the generator uses 1/(1-theta), main() rejects more.
+ */
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(size_t items, double theta, size_t threads = 1)
+    : _items(items)
+    , _theta(theta)
+    , _zetan(zeta(items, theta, threads))
+    , _alpha(1.0 / (1.0 - theta))
+    , _eta((1.0 - std::pow(2.0 / items, 1.0 - theta)) / (1.0 - zeta(2, theta, 1) / _zetan))
+    , _half(1.0 + std::pow(0.5, theta))
+    {
+    }
+
+    __attribute__((always_inline))
+    size_t next(Random& rng) const {
+        double u = rng.nextDouble();
+        double uz = u * _zetan;
+        if(uz < 1.0) return 0;
+        if(uz < _half) return 1;
+        size_t r = _items * std::pow(_eta * u - _eta + 1.0, _alpha);
+        return r < _items ? r : _items - 1;
+    }
+
+    size_t items() const {
+        return _items;
+    }
+
+    static double zeta(size_t n, double theta, size_t threads) {
+        if(threads <= 1 || n < (1ULL << 16)) {
+            double sum = 0.0;
+            for(size_t i = 1; i <= n; ++i) sum += 1.0 / std::pow((double)i, theta);
+            return sum;
+        }
+        std::vector<double> sums(threads, 0.0);
+        std::vector<std::thread> workers;
+        for(size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&sums, n, theta, threads, t]() {
+                double sum = 0.0;
+                for(size_t i = 1 + t; i <= n; i += threads) sum += 1.0 / std::pow((double)i, theta);
+                sums[t] = sum;
+            });
+        }
+        double sum = 0.0;
+        for(size_t t = 0; t < threads; ++t) {
+            workers[t].join();
+            sum += sums[t];
+        }
+        return sum;
+    }
+
+private:
+    size_t _items;
+    double _theta;
+    double _zetan;
+    double _alpha;
+    double _eta;
+    double _half;
+};
+
+/**
+ * Runs one phase on the given number of threads. Every thread first runs
+ * init(tid), then all wait for each other and run body(tid). Returns the
+ * wall-clock time between the start of the bodies and the last one finishing.
+ */
+template<typename INIT, typename BODY>
+double runThreads(size_t threads, INIT&& init, BODY&& body) {
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for(size_t tid = 0; tid < threads; ++tid) {
+        workers.emplace_back([&, tid]() {
+            init(tid);
+            ready.fetch_add(1, std::memory_order_release);
+            while(!go.load(std::memory_order_acquire)) _mm_pause();
+            body(tid);
+        });
+    }
+    while(ready.load(std::memory_order_acquire) < threads) _mm_pause();
+    Timer timer;
+    go.store(true, std::memory_order_release);
+    for(auto& w: workers) {
+        w.join();
+    }
+    return timer.getElapsedSeconds();
+}
+
+inline double settingAsDouble(std::string const& key, double def) {
+    std::string s = Settings::global()[key].asString();
+    return s.empty() ? def : std::stod(s);
+}
+
+inline size_t settingAsUnsigned(std::string const& key, size_t def) {
+    std::string s = Settings::global()[key].asString();
+    return s.empty() ? def : std::stoull(s);
+}
+
+/**
+ * Called by the drivers at the end of every phase. Only does something for
+ * wrapped implementations, see latency.h.
+ */
+template<typename IMPL>
+void endPhase(IMPL& impl, std::string const& phase) {
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+// Whether the slots of the insitu and mmapquadtable tables carry a table
+// generation, which decides what their clear() costs.
+//
+// Untagged, the default, keeps the 16 bits of hash in the top of a slot and
+// counts a slot as live if it is not 0. clear() zeroes the bucket array with
+// MMapper::wipe before it returns.
+//
+// GenerationTagged takes the top 8 of those bits for the generation of the
+// table, leaving 8 bits of hash: a slot from another generation counts as
+// empty, so clear() only bumps the generation. Every probe compares the
+// generation as well, and a filter of 8 bits lets through 1/256 of the
+// other keys instead of 1/65536. When the generation wraps, clear() swaps in
+// a fresh mapping, whose pages are zero-filled as they are touched, and a
+// thread in the background unmaps the old one.
+
+#include <cstddef>
+#include <thread>
+
+#include "mmapper.h"
+
+namespace hashtables {
+
+class Untagged {
+public:
+
+    static constexpr size_t HASH_MASK = 0xFFFF000000000000ULL;
+
+    size_t tag() const {
+        return 0;
+    }
+
+    bool isLive(size_t word) const {
+        return word != 0;
+    }
+
+    template<typename T>
+    bool isLive(T* ptr) const {
+        return isLive((size_t)ptr);
+    }
+
+    static size_t untag(size_t word) {
+        return word;
+    }
+
+    /**
+     * Empties map, which has bytes bytes. Must not run concurrently with
+     * other operations on the table.
+     */
+    template<typename T>
+    void clear(T*& map, size_t bytes) {
+        MMapper::wipe(map, bytes);
+    }
+};
+
+class GenerationTagged {
+public:
+
+    static constexpr size_t GENERATION_SHIFT = 56;
+    static constexpr size_t GENERATION_MASK = 0xFF00000000000000ULL;
+    static constexpr size_t HASH_MASK = 0x00FF000000000000ULL;
+
+    GenerationTagged() = default;
+    GenerationTagged(GenerationTagged const&) = delete;
+    GenerationTagged& operator=(GenerationTagged const&) = delete;
+
+    ~GenerationTagged() {
+        joinWiper();
+    }
+
+    size_t tag() const {
+        return _generation;
+    }
+
+    bool isLive(size_t word) const {
+        return (word & GENERATION_MASK) == _generation;
+    }
+
+    template<typename T>
+    bool isLive(T* ptr) const {
+        return isLive((size_t)ptr);
+    }
+
+    static size_t untag(size_t word) {
+        return word & ~GENERATION_MASK;
+    }
+
+    /**
+     * Empties map in O(1) by moving to the next generation. Must not run
+     * concurrently with other operations on the table.
+     */
+    template<typename T>
+    void clear(T*& map, size_t bytes) {
+        _generation += 1ULL << GENERATION_SHIFT;
+        if(_generation != 0ULL) return;
+        _generation = 1ULL << GENERATION_SHIFT;
+        joinWiper();
+        T* old = map;
+        map = (T*)MMapper::mmapForMap(bytes);
+        _wiper = std::thread([old, bytes]() {
+            MMapper::munmap(old, bytes);
+        });
+    }
+
+private:
+
+    void joinWiper() {
+        if(_wiper.joinable()) _wiper.join();
+    }
+
+private:
+    size_t _generation = 1ULL << GENERATION_SHIFT;
+    std::thread _wiper;
+};
+
+}
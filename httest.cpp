@@ -17,6 +17,7 @@ extern "C" {
 #define HM_USE_DTREE 1
 
 #include <cassert>
+#include <cctype>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
@@ -33,6 +34,7 @@ extern "C" {
 #include <string>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 #include <unistd.h>
@@ -47,9 +49,11 @@ extern "C" {
 #include "mmapquadtableC.h"
 #include "mmapquadtableCU.h"
 #include "mmapquadtableCUV.h"
+#include "mmapquadtableE.h"
 #include "chaintable.h"
 #include "chaintableUB.h"
 #include "chaintableUBVK.h"
+#include "chaintablesplitUBVK.h"
 #include "chaintableV.h"
 #include "chaintablegeneric.h"
 #include "chaintableints.h"
@@ -61,8 +65,10 @@ extern "C" {
 #include "cachechain3upperbits.h"
 #include "cachechain3vkeysize.h"
 #include "cachechain3UBVK.h"
+#include "interner.h"
 #include "mmapmmap.h"
 #include "insituUB.h"
+#include "insituUBgrow.h"
 #include "insituUBquad.h"
 #include "insituQuad.h"
 #include "insituRevCasUB.h"
@@ -73,17 +79,33 @@ extern "C" {
 #include "insituQ32.h"
 #include "openaddr.h"
 #include "ht.h"
+#include "sharded.h"
 #include "PTAHash.h"
 
 #include "test_ints.h"
 #include "test_ints2.h"
 #include "test_ints3.h"
+#include "test_skewed.h"
 #include "test_strings.h"
 #include "test_words.h"
 #include "test_vectors.h"
 
 #include "tests/common.h"
 #include "common/timer.h"
+#include "simple.h"
+#include "workload.h"
+#include "latency.h"
+#include "memory.h"
+#include "misses.h"
+#include "contention.h"
+#include "tables.h"
+#include "affine.h"
+#include "readwrite.h"
+#include "trace.h"
+#include "perfcounters.h"
+#include "openloop.h"
+#include "topology.h"
+#include "results.h"
 
 #include "wrappers.h"
 #include "mystring.h"
@@ -193,7 +215,7 @@ public:
 
     __attribute__((always_inline))
     void insert(K const& k, V const& v) {
-        ht->insert(k, v);
+        hashtables::insertCountingFull(*ht, k, v);
     }
 
     __attribute__((always_inline))
@@ -238,7 +260,7 @@ public:
 
     __attribute__((always_inline))
     void insert(key_type const& k, value_type const& v) {
-        ht->insert(k, v);
+        hashtables::insertCountingFull(*ht, k, v);
     }
 
     __attribute__((always_inline))
@@ -439,6 +461,122 @@ public:
     }
 };
 
+/**
+ * Starts at 2^--initial_scale buckets (default --buckets_scale) and splits
+ * them one at a time as the load rises, see chaintablesplitUBVK.h.
+ */
+template<typename K, typename V>
+class ImplChainSplitUBVK: public ImplMyAPI<chaintablesplitUBVK::HashTable, K, V> {
+public:
+
+    ImplChainSplitUBVK(): ImplMyAPI<chaintablesplitUBVK::HashTable, K, V>("ChainUVS") {}
+
+    __attribute__((always_inline))
+    void init(size_t bucketScale) {
+        this->ht = new chaintablesplitUBVK::HashTable<K,V>(settingAsUnsigned("initial_scale", bucketScale));
+    }
+
+    __attribute__((always_inline))
+    void statsString(std::ostream& out, size_t bars) {
+        (void)bars;
+        typename chaintablesplitUBVK::HashTable<K,V>::stats stats;
+        this->ht->getStats(stats);
+        out << "size: " << stats.size
+            << ", buckets: " << stats.usedBuckets
+            << ", cols: " << stats.collisions
+            << ", avg chn: " << stats.avgChainLength
+            << ", lngst chn: " << stats.longestChain
+            << ", scale: " << this->ht->bucketsScale()
+            ;
+        out << std::endl;
+    }
+};
+
+template<typename K, typename V>
+class ImplChainGenericUBVKX: public ImplMyAPI<chaintablegenericUBVK::ExternalKeyHashTable, K, V> {
+public:
+
+    ImplChainGenericUBVKX(): ImplMyAPI<chaintablegenericUBVK::ExternalKeyHashTable, K, V>("ChainUVX") {}
+
+    __attribute__((always_inline))
+    void statsString(std::ostream& out, size_t bars) {
+        typename chaintablegenericUBVK::ExternalKeyHashTable<K,V>::stats stats;
+        this->ht->getStats(stats);
+        out << "size: " << stats.size
+            << ", buckets: " << stats.usedBuckets
+            << ", cols: " << stats.collisions
+            << ", avg chn: " << stats.avgChainLength
+            << ", lngst chn: " << stats.longestChain
+            ;
+        out << std::endl;
+        std::vector<size_t> elements;
+        elements.reserve(bars);
+        this->ht->getDensityStats(bars, elements);
+        printDensitygraph(out, elements);
+    }
+};
+
+/**
+ * Interns the keys and keeps the values in an array indexed by the ids, the
+ * way a table keyed on the ids would use the interner.
+ */
+template<typename K, typename V>
+class ImplIntern: public HTImpl {
+public:
+
+    using key_type = K;
+    using value_type = V;
+
+    __attribute__((always_inline))
+    void init(size_t bucketScale) {
+        interner = new StringInterner<K>(bucketScale);
+        values = (V*)MMapper::mmapForMap((1ULL << bucketScale) * sizeof(V));
+        valuesBytes = (1ULL << bucketScale) * sizeof(V);
+    }
+
+    __attribute__((always_inline))
+    void thread_init(int tid) {
+        (void)tid;
+        interner->thread_init();
+    }
+
+    __attribute__((always_inline))
+    void insert(K const& k, V const& v) {
+        uint32_t id = interner->intern(k);
+        if(id != StringInterner<K>::NONE) values[id] = v;
+    }
+
+    __attribute__((always_inline))
+    bool get(K const& k, V& v) {
+        uint32_t id;
+        if(!interner->find(k, id)) return false;
+        v = values[id];
+        return true;
+    }
+
+    __attribute__((always_inline))
+    void cleanup() {
+        MMapper::munmap(values, valuesBytes);
+        delete interner;
+    }
+
+    __attribute__((always_inline))
+    std::string name() const {
+        return "Intern<" + std::string(typeid(K).name()) + "," + std::string(typeid(V).name()) + ">";
+    }
+
+    __attribute__((always_inline))
+    void statsString(std::ostream& out, size_t bars) {
+        (void)bars;
+        out << "ids: " << interner->size() << std::endl;
+    }
+
+private:
+    StringInterner<K>* interner;
+    V* values;
+    size_t valuesBytes;
+};
+
 template<typename K, typename V>
 class ImplChainGenericV: public ImplMyAPI<chaintablegenericV::HashTable, K, V> {
 public:
@@ -531,7 +669,7 @@ public:
 
     __attribute__((always_inline))
     void insert(K const& k, V const& v) {
-        ht->insert(k, v);
+        hashtables::insertCountingFull(*ht, k, v);
     }
 
     __attribute__((always_inline))
@@ -733,6 +871,30 @@ public:
     }
 };
 
+template<typename K, typename V>
+class ImplMmapQuadCUVX: public ImplMyAPI<mmapquadtableCUV::ExternalKeyHashTable, K, V> {
+public:
+
+    ImplMmapQuadCUVX(): ImplMyAPI<mmapquadtableCUV::ExternalKeyHashTable, K, V>("MmapQCUVX") {}
+
+    __attribute__((always_inline))
+    void statsString(std::ostream& out, size_t bars) {
+        typename mmapquadtableCUV::ExternalKeyHashTable<K,V>::stats stats;
+        this->ht->getStats(stats);
+        out << "size: " << stats.size
+            << ", buckets: " << stats.usedBuckets
+            << ", cols: " << stats.collisions
+            << ", avg b. size: " << stats.avgBucketSize
+            << ", bgst bucket: " << stats.biggestBucket
+            ;
+        out << std::endl;
+        std::vector<size_t> elements;
+        elements.reserve(bars);
+        this->ht->getDensityStats(bars, elements);
+        printDensitygraph(out, elements);
+    }
+};
+
 template<typename K, typename V>
 class ImplMmapQuadCUV0: public ImplMyAPI<mmapquadtableCUV0::HashTable, K, V> {
 public:
@@ -757,6 +919,39 @@ public:
     }
 };
 
+/**
+ * Starts at 2^--initial_scale slots (default --buckets_scale) in segments of
+ * 2^--segment_scale and splits them as they fill, see mmapquadtableE.h.
+ */
+template<typename K, typename V>
+class ImplMmapQuadE: public ImplMyAPI<mmapquadtableE::HashTable, K, V> {
+public:
+
+    ImplMmapQuadE(): ImplMyAPI<mmapquadtableE::HashTable, K, V>("MmapQE") {}
+
+    __attribute__((always_inline))
+    void init(size_t bucketScale) {
+        this->ht = new mmapquadtableE::HashTable<K,V>(settingAsUnsigned("initial_scale", bucketScale));
+    }
+
+    __attribute__((always_inline))
+    void statsString(std::ostream& out, size_t bars) {
+        (void)bars;
+        typename mmapquadtableE::HashTable<K,V>::stats stats;
+        this->ht->getStats(stats);
+        out << "size: " << stats.size
+            << ", buckets: " << stats.usedBuckets
+            << ", cols: " << stats.collisions
+            << ", avg b. size: " << stats.avgBucketSize
+            << ", bgst bucket: " << stats.biggestBucket
+            << ", depth: " << this->ht->depth()
+            << ", segments: " << this->ht->segments()
+            << ", splits: " << this->ht->splits()
+            ;
+        out << std::endl;
+    }
+};
+
 template<typename K, typename V>
 class ImplOpenAddr: public ImplMyAPI2<openaddr::HashTable<K, V, MurmurHasher>> {
 public:
@@ -781,6 +976,100 @@ public:
     }
 };
 
+/**
+ * SHARDS tables of type HT, see sharded.h. --shard_scales=s0,s1,... sizes the
+ * shards one by one; by default they share the buckets of --buckets_scale.
+ * With --pin, shard s prefers the node of thread s % threads, its first
+ * thread in --mode=affine.
+ */
+template<typename K, typename V, typename HT, size_t SHARDS>
+class ImplSharded: public HTImpl {
+public:
+
+    using key_type = K;
+    using value_type = V;
+
+    ImplSharded(std::string const& name): _name(name) {}
+
+    void init(size_t bucketScale) {
+        Settings& settings = Settings::global();
+        std::vector<size_t> scales;
+        std::stringstream list(settings["shard_scales"].asString());
+        std::string scale;
+        while(std::getline(list, scale, ',')) {
+            if(!scale.empty()) scales.push_back(std::stoull(scale));
+        }
+        std::vector<int> nodes;
+        size_t threads = settings["threads"].asUnsignedValue();
+        if(Topology::get().pinning() && threads) {
+            for(size_t s = 0; s < SHARDS; ++s) {
+                nodes.push_back(Topology::get().nodeOf(s % threads));
+            }
+        }
+        ht = new hashtables::Sharded<HT, SHARDS>(bucketScale, scales, nodes);
+    }
+
+    __attribute__((always_inline))
+    void thread_init(int tid) {
+        (void)tid;
+        ht->thread_init();
+    }
+
+    __attribute__((always_inline))
+    void insert(K const& k, V const& v) {
+        hashtables::insertCountingFull(*ht, k, v);
+    }
+
+    __attribute__((always_inline))
+    bool get(K const& k, V& v) {
+        return ht->get(k, v);
+    }
+
+    __attribute__((always_inline))
+    void cleanup() {
+        delete ht;
+    }
+
+    std::string name() const {
+        return _name + "<" + std::string(typeid(K).name()) + "," + std::string(typeid(V).name()) + ">";
+    }
+
+    size_t shards() const {
+        return SHARDS;
+    }
+
+    __attribute__((always_inline))
+    size_t shardOf(K const& k) const {
+        return ht->shardOf(k);
+    }
+
+    void statsString(std::ostream& out, size_t bars) {
+        (void)bars;
+        for(size_t s = 0; s < SHARDS; ++s) {
+            auto shard = ht->shardStats(s);
+            size_t size = 0;
+            size_t usedBuckets = 0;
+            ht->forEachTable(s, [&size, &usedBuckets](HT& table) {
+                typename HT::stats stats;
+                table.getStats(stats);
+                size += stats.size;
+                usedBuckets += stats.usedBuckets;
+            });
+            out << "shard " << s
+                << ": size: " << size
+                << ", buckets: " << usedBuckets
+                << ", generations: " << shard.generations
+                << ", scale: " << shard.bucketsScale
+                << ", full: " << shard.fullInserts
+                << std::endl;
+        }
+    }
+
+protected:
+    std::string _name;
+    hashtables::Sharded<HT, SHARDS>* ht;
+};
+
 template<typename K, typename V>
 class ImplGenHT: public ImplMyAPI2<genht::HashTable<K, V, MurmurHasher>> {
 public:
@@ -1482,6 +1771,39 @@ public:
     }
 };
 
+/**
+ * Starts at 2^--initial_scale slots (default --buckets_scale) and grows, see
+ * insituUBgrow.h. The growt tables start at the same size, so both end up
+ * sized for the same keys.
+ */
+template<typename K, typename V>
+class ImplInsituUGrow: public ImplMyAPI<insituUBgrow::HashTable, K, V> {
+public:
+
+    ImplInsituUGrow(): ImplMyAPI<insituUBgrow::HashTable, K, V>("InsituUFG") {}
+
+    __attribute__((always_inline))
+    void init(size_t bucketScale) {
+        this->ht = new insituUBgrow::HashTable<K,V>(settingAsUnsigned("initial_scale", bucketScale));
+    }
+
+    __attribute__((always_inline))
+    void statsString(std::ostream& out, size_t bars) {
+        (void)bars;
+        typename insituUBgrow::HashTable<K,V>::stats stats;
+        this->ht->getStats(stats);
+        out << "size: " << stats.size
+            << ", buckets: " << stats.usedBuckets
+            << ", cols: " << stats.collisions
+            << ", avg b. size: " << stats.avgBucketSize
+            << ", bgst bucket: " << stats.biggestBucket
+            << ", scale: " << this->ht->bucketsScale()
+            << ", growths: " << this->ht->growths()
+            ;
+        out << std::endl;
+    }
+};
+
 template<typename K, typename V>
 class ImplInsituUBquad: public ImplMyAPI<insituUBquad::HashTable, K, V> {
 public:
@@ -1677,6 +1999,119 @@ public:
 //std::atomic<int> my_string::total_copies;
 //std::atomic<int> my_string::total_moves;
 
+/**
+ * Runs the driver selected with --mode=...:
+ *   simple   - insert all keys, then verify them (default), see simple.h
+ *   workload - YCSB-style mixed workload, see workload.h
+ *   openloop - the same workload at a fixed offered rate, see openloop.h
+ *   miss     - gets at the hit ratios of --hit_ratios, see misses.h
+ *   contention - all threads insert the same few keys, see contention.h
+ *   readwrite - lookups while other threads insert, see readwrite.h
+ *   replay   - the operations of --trace, see trace.h
+ *   tables   - many tables filled at once; runs from runSelectedTest, see tables.h
+ *   affine   - every thread on its own shards; runs from runSelectedTest, see affine.h
+ */
+template<typename TEST, typename IMPL>
+void runDriver(TEST& test, IMPL& impl) {
+    std::string mode = Settings::global()["mode"].asString();
+    if(mode == "simple") {
+        SimpleDriver<TEST, IMPL>(test, impl).test();
+        endPhase(impl, "simple");
+    } else if(mode == "workload") {
+        WorkloadTest<TEST, IMPL>(test, impl).test();
+    } else if(mode == "openloop") {
+        OpenLoopTest<TEST, IMPL>(test, impl).test();
+    } else if(mode == "miss") {
+        MissTest<TEST, IMPL>(test, impl).test();
+    } else if(mode == "contention") {
+        ContentionTest<TEST, IMPL>(test, impl).test();
+    } else if(mode == "readwrite") {
+        ReadWriteTest<TEST, IMPL>(test, impl).test();
+    } else if(mode == "replay") {
+        ReplayTest<TEST, IMPL>(test, impl).test();
+    } else {
+        std::cerr << "Unknown mode: " << mode << std::endl;
+    }
+}
+
+template<typename TEST, typename IMPL>
+void runWithPinning(TEST& test, IMPL& impl) {
+    if(Topology::get().pinning()) {
+        ImplPinned<IMPL> pinnedImpl(impl);
+        runDriver(test, pinnedImpl);
+    } else {
+        runDriver(test, impl);
+    }
+}
+
+template<typename TEST, typename IMPL>
+void runWithTrace(TEST& test, IMPL& impl) {
+    if(!Settings::global()["record"].asString().empty()) {
+        ImplTrace<IMPL> traceImpl(impl);
+        runWithPinning(test, traceImpl);
+    } else {
+        runWithPinning(test, impl);
+    }
+}
+
+template<typename TEST, typename IMPL>
+void runWithLatency(TEST& test, IMPL& impl) {
+    if(Settings::global()["latency"].asUnsignedValue()) {
+        ImplLatency<IMPL> latencyImpl(impl);
+        runWithTrace(test, latencyImpl);
+        latencyImpl.report();
+    } else {
+        runWithTrace(test, impl);
+    }
+}
+
+template<typename TEST, typename IMPL>
+void runWithMemory(TEST& test, IMPL& impl) {
+    if(Settings::global()["memory"].asUnsignedValue()) {
+        ImplMemory<IMPL> memoryImpl(impl);
+        runWithLatency(test, memoryImpl);
+        memoryImpl.report();
+    } else {
+        runWithLatency(test, impl);
+    }
+}
+
+/**
+ * Runs the selected driver --repeat times on impl, wrapped in ImplPerf if
+ * --perf is set, in ImplMemory if --memory=1, in ImplLatency if --latency=1,
+ * in ImplTrace if --record is set and in ImplPinned if --pin is set. Every
+ * run becomes a record of the --results, with the inserts that were dropped
+ * because the table was FULL as inserts.full; a run that dropped any warns.
+ * --mode=tables copies impl per table and --mode=affine needs its shards, so
+ * they run unwrapped.
+ */
+template<typename TEST, typename IMPL>
+void runSelectedTest(TEST& test, IMPL& impl) {
+    size_t repeat = std::max<size_t>(1, Settings::global()["repeat"].asUnsignedValue());
+    for(size_t r = 0; r < repeat; ++r) {
+        if(Results::get().enabled()) {
+            Results::get().begin(impl.name(), r);
+        }
+        size_t fullBefore = hashtables::FullInserts::total();
+        if(Settings::global()["mode"].asString() == "tables") {
+            TablesTest<TEST, IMPL>(test, impl).test();
+        } else if(Settings::global()["mode"].asString() == "affine") {
+            AffineTest<TEST, IMPL>(test, impl).test();
+        } else if(Settings::global()["perf"].asUnsignedValue()) {
+            ImplPerf<IMPL> perfImpl(impl);
+            runWithMemory(test, perfImpl);
+            perfImpl.report();
+        } else {
+            runWithMemory(test, impl);
+        }
+        size_t full = hashtables::FullInserts::total() - fullBefore;
+        if(full) {
+            std::cout << "warning: " << full << " inserts into " << impl.name() << " were dropped, the table was FULL (see probing.h)" << std::endl;
+        }
+        Results::get().set("inserts.full", full);
+    }
+}
+
 void runTest(std::string const& htName) {
 //    typedef boost::mpl::vector<ImplChain, ImplCLHT, ImplCpp, ImplDivineHT, ImplMmap<size_t,size_t>, ImplCacheChain> vec;
 //    boost::mpl::for_each<vec>(value_printer{htName});
@@ -1685,1051 +2120,1217 @@ void runTest(std::string const& htName) {
     } else if(htName == "ChainInts:i") {
         ImplChainInts impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Chain:i") {
         ImplChain<size_t,size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainSlab:i") {
         ImplChainSlab<size_t,size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainU:i") {
         ImplChainGenericUB<size_t,size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainUV:i") {
         ImplChainGenericUBVK<size_t,size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainUVS:i") {
+        ImplChainSplitUBVK<size_t,size_t> impl;
+        TestInts::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
     } else if(htName == "ChainV:i") {
         ImplChainGenericV<size_t,size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC7:i") {
         ImplCacheChain<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC0:i") {
         ImplCacheChain2<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain2C:i") {
         ImplCacheChain2Config<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC:i") {
         ImplCacheChain3<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain3AC:i") {
         ImplCacheChain3AC<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCV:i") {
         ImplCacheChain3VK<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCU:i") {
         ImplCacheChain3UB<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCUV:i") {
         ImplCacheChain3UBVK<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChunkHT:i") {
         ImplChunkHT impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Mmap:i") {
         ImplMmap<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapU:i") {
         ImplMmapU<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapC:i") {
         ImplMmapCache<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQ:i") {
         ImplMmapQuad<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQC:i") {
         ImplMmapQuadC<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCU:i") {
         ImplMmapQuadCU<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCUV:i") {
         ImplMmapQuadCUV<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCUV0:i") {
         ImplMmapQuadCUV0<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQE:i") {
+        ImplMmapQuadE<size_t, size_t> impl;
+        TestInts::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ShardedInsituUF:i") {
+        ImplSharded<size_t, size_t, insituUB::HashTable<size_t, size_t>, 16> impl("Sharded16InsituUF");
+        TestInts::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ShardedMmapQCUV:i") {
+        ImplSharded<size_t, size_t, mmapquadtableCUV::HashTable<size_t, size_t>, 16> impl("Sharded16MmapQCUV");
+        TestInts::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ShardedMmapC:i") {
+        ImplSharded<size_t, size_t, mmapcachetable::HashTable<size_t, size_t>, 16> impl("Sharded16MmapC");
+        TestInts::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ShardedOpenAddr:i") {
+        ImplSharded<size_t, size_t, openaddr::HashTable<size_t, size_t, MurmurHasher>, 16> impl("Sharded16OpenAddr");
+        TestInts::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ShardedChainU:i") {
+        ImplSharded<size_t, size_t, chaintablegenericUB::HashTable<size_t, size_t>, 16> impl("Sharded16ChainU");
+        TestInts::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
     } else if(htName == "MmapMmap:i") {
         ImplMmapMmap<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituUF:i") {
         ImplInsituU<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
+    } else if(htName == "InsituUFG:i") {
+        ImplInsituUGrow<size_t, size_t> impl;
+        TestInts::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQUF:i") {
         ImplInsituUBquad<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQ:i") {
         ImplInsituQuad<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituRevCasU:i") {
         ImplInsituRevCasUB<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituRevCasQU:i") {
         ImplInsituRevCasUBquad<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituDU:i") {
         ImplInsituDCASUB<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQDU:i") {
         ImplInsituDCASUBquad<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Insitu32:i") {
         ImplInsitu32<__uint32_t, __uint32_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQ32:i") {
         ImplInsituQ32<__uint32_t, __uint32_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR
     } else if(htName == "dbsll:i") {
         ImplDBSLL<size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "dbsllold:i") {
         ImplDBSLLOld<size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "TBBF:i") {
         ImplTBBHashMapDefaultAllocator<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "TBBF.ma:i") {
         ImplTBBHashMapMyAllocator<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #ifdef HAVE_CLHT
     } else if(htName == "CLHT:i") {
         ImplCLHT impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #ifdef HAVE_DIVINE
     } else if(htName == "DIVINE:i") {
         ImplDivineHT<size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "Junction.Crude:i") {
         ImplJunctionCrude<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Crude.Murmur:i") {
         ImplJunctionCrudeMurmur<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Linear:i") {
         ImplJunctionLinear<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.LeapFrog:i") {
         ImplJunctionLeapFrog<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Grampa:i") {
         ImplJunctionGrampa<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Sylvan:i") {
         ImplSylvan<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell:i") {
         ImplBytell<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell_s:i") {
         ImplBytell_s<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gsparse:i") {
         ImplGoogleSparseHash<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gsparse_s:i") {
         ImplGoogleSparseHash_s<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gdense:i") {
         ImplGoogleDenseHash<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gdense_s:i") {
         ImplGoogleDenseHash_s<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "libcuckoo.sa:i") {
         ImplLibCuckooSA<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "libcuckoo.ma:i") {
         ImplLibCuckooMA<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "folklore:i") {
         ImplGrowtFolklore<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "uaGrow:i") {
         ImplGrowtUAGrow<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "usGrow:i") {
         ImplGrowtUSGrow<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "usnGrow:i") {
         ImplGrowtUSNGrow<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "paGrow:i") {
         ImplGrowtPAGrow<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "psGrow:i") {
         ImplGrowtPSGrow<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "psnGrow:i") {
         ImplGrowtPSNGrow<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_LIBCDS
     } else if(htName == "michaelML:i") {
         ImplCDSMichaelMLNOGC<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "michaelMLMA:i") {
         ImplCDSMichaelMLNOGCMA<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "michaelMLSA:i") {
         ImplCDSMichaelMLNOGCSA<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "michaelMLDHP:i") {
         ImplCDSMichaelMLDHP<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 //    } else if(htName == "michaelLL:i") {
 //        ImplCDSMichaelLLNOGC<size_t, size_t> impl;
 //        TestInts::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
     } else if(htName == "skiplist:i") {
         ImplCDSSkipList<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "splitlist:i") {
         ImplCDSSplitList<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "splitlistMA:i") {
         ImplCDSSplitListMA<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR_FOLLY
     } else if(htName == "folly:i") {
         ImplFolly<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "follyQ:i") {
         ImplFollyQ<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "follyQMA:i") {
         ImplFollyQMA<size_t, size_t> impl;
         TestInts::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #endif
 #if HM_USE_OWN
     } else if(htName == "ChainInts:j") {
         ImplChainInts impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Chain:j") {
         ImplChain<size_t,size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainSlab:j") {
         ImplChainSlab<size_t,size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainU:j") {
         ImplChainGenericUB<size_t,size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 
     } else if(htName == "ChainUV:j") {
         ImplChainGenericUBVK<size_t,size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainV:j") {
         ImplChainGenericV<size_t,size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC7:j") {
         ImplCacheChain<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC0:j") {
         ImplCacheChain2<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain2C:j") {
         ImplCacheChain2Config<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC:j") {
         ImplCacheChain3<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain3AC:j") {
         ImplCacheChain3AC<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCV:j") {
         ImplCacheChain3VK<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCU:j") {
         ImplCacheChain3UB<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCUV:j") {
         ImplCacheChain3UBVK<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChunkHT:j") {
         ImplChunkHT impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Mmap:j") {
         ImplMmap<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapU:j") {
         ImplMmapU<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapC:j") {
         ImplMmapCache<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQ:j") {
         ImplMmapQuad<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQC:j") {
         ImplMmapQuadC<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCU:j") {
         ImplMmapQuadCU<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCUV:j") {
         ImplMmapQuadCUV<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCUV0:j") {
         ImplMmapQuadCUV0<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapMmap:j") {
         ImplMmapMmap<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituU:j") {
         ImplInsituU<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQU:j") {
         ImplInsituUBquad<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituRevCasU:j") {
         ImplInsituRevCasUB<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituRevCasQU:j") {
         ImplInsituRevCasUBquad<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituDU:j") {
         ImplInsituDCASUB<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQDU:j") {
         ImplInsituDCASUBquad<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Insitu32:j") {
         ImplInsitu32<__uint32_t, __uint32_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQ32:j") {
         ImplInsituQ32<__uint32_t, __uint32_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituUF:j") {
         ImplInsituU<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQUF:j") {
         ImplInsituUBquad<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "PTAHash:j") {
         ImplPTAHash<size_t,size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR
     } else if(htName == "dbsll:j") {
         ImplDBSLL<size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "dbsllold:j") {
         ImplDBSLLOld<size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "TBBF:j") {
         ImplTBBHashMapDefaultAllocator<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "TBBF.ma:j") {
         ImplTBBHashMapMyAllocator<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #ifdef HAVE_CLHT
     } else if(htName == "CLHT:j") {
         ImplCLHT impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #ifdef HAVE_DIVINE
     } else if(htName == "DIVINE:j") {
         ImplDivineHT<size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "Junction.Crude:j") {
         ImplJunctionCrude<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Crude.Murmur:j") {
         ImplJunctionCrudeMurmur<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Linear:j") {
         ImplJunctionLinear<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.LeapFrog:j") {
         ImplJunctionLeapFrog<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Grampa:j") {
         ImplJunctionGrampa<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Sylvan:j") {
         ImplSylvan<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell:j") {
         ImplBytell<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gsparse:j") {
         ImplGoogleSparseHash<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gsparse_s:j") {
         ImplGoogleSparseHash_s<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gdense:j") {
         ImplGoogleDenseHash<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gdense_s:j") {
         ImplGoogleDenseHash_s<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell_s:j") {
         ImplBytell_s<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "libcuckoo.sa:j") {
         ImplLibCuckooSA<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "libcuckoo.ma:j") {
         ImplLibCuckooMA<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "folklore:j") {
         ImplGrowtFolklore<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "uaGrow:j") {
         ImplGrowtUAGrow<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "usGrow:j") {
         ImplGrowtUSGrow<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "usnGrow:j") {
         ImplGrowtUSNGrow<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "paGrow:j") {
         ImplGrowtPAGrow<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "psGrow:j") {
         ImplGrowtPSGrow<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "psnGrow:j") {
         ImplGrowtPSNGrow<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_LIBCDS
     } else if(htName == "michaelML:j") {
         ImplCDSMichaelMLNOGC<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "michaelMLMA:j") {
         ImplCDSMichaelMLNOGCMA<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "michaelMLSA:j") {
         ImplCDSMichaelMLNOGCSA<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "michaelMLDHP:j") {
         ImplCDSMichaelMLDHP<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 //    } else if(htName == "michaelLL:i") {
 //        ImplCDSMichaelLLNOGC<size_t, size_t> impl;
 //        TestInts::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
     } else if(htName == "skiplist:j") {
         ImplCDSSkipList<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "splitlist:j") {
         ImplCDSSplitList<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "splitlistMA:j") {
         ImplCDSSplitListMA<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR_FOLLY
     } else if(htName == "folly:j") {
         ImplFolly<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "follyQ:j") {
         ImplFollyQ<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "follyQMA:j") {
         ImplFollyQMA<size_t, size_t> impl;
         TestInts2::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #endif
 #if HM_USE_OWN
     } else if(htName == "ChainInts:k") {
         ImplChainInts impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Chain:k") {
         ImplChain<size_t,size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainSlab:k") {
         ImplChainSlab<size_t,size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainU:k") {
         ImplChainGenericUB<size_t,size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 
     } else if(htName == "ChainUV:k") {
         ImplChainGenericUBVK<size_t,size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainV:k") {
         ImplChainGenericV<size_t,size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC7:k") {
         ImplCacheChain<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC0:k") {
         ImplCacheChain2<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain2C:k") {
         ImplCacheChain2Config<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC:k") {
         ImplCacheChain3<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain3AC:k") {
         ImplCacheChain3AC<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCV:k") {
         ImplCacheChain3VK<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCU:k") {
         ImplCacheChain3UB<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCUV:k") {
         ImplCacheChain3UBVK<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChunkHT:k") {
         ImplChunkHT impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Mmap:k") {
         ImplMmap<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapU:k") {
         ImplMmapU<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapC:k") {
         ImplMmapCache<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQ:k") {
         ImplMmapQuad<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQC:k") {
         ImplMmapQuadC<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCU:k") {
         ImplMmapQuadCU<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCUV:k") {
         ImplMmapQuadCUV<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCUV0:k") {
         ImplMmapQuadCUV0<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapMmap:k") {
         ImplMmapMmap<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituU:k") {
         ImplInsituU<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQU:k") {
         ImplInsituUBquad<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituRevCasU:k") {
         ImplInsituRevCasUB<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituRevCasQU:k") {
         ImplInsituRevCasUBquad<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituDU:k") {
         ImplInsituDCASUB<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQDU:k") {
         ImplInsituDCASUBquad<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Insitu32:k") {
         ImplInsitu32<__uint32_t, __uint32_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQ32:k") {
         ImplInsituQ32<__uint32_t, __uint32_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituUF:k") {
         ImplInsituU<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "InsituQUF:k") {
         ImplInsituUBquad<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "PTAHash:k") {
         ImplPTAHash<size_t,size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "OpenAddr:k") {
         ImplOpenAddr<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR
     } else if(htName == "dbsll:k") {
         ImplDBSLL<size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "dbsllold:k") {
         ImplDBSLLOld<size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "TBBF:k") {
         ImplTBBHashMapDefaultAllocator<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "TBBF.ma:k") {
         ImplTBBHashMapMyAllocator<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #ifdef HAVE_CLHT
     } else if(htName == "CLHT:k") {
         ImplCLHT impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #ifdef HAVE_DIVINE
     } else if(htName == "DIVINE:k") {
         ImplDivineHT<size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "Junction.Crude:k") {
         ImplJunctionCrude<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Crude.Murmur:k") {
         ImplJunctionCrudeMurmur<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Linear:k") {
         ImplJunctionLinear<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.LeapFrog:k") {
         ImplJunctionLeapFrog<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Junction.Grampa:k") {
         ImplJunctionGrampa<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Sylvan:k") {
         ImplSylvan<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell:k") {
         ImplBytell<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gsparse:k") {
         ImplGoogleSparseHash<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gsparse_s:k") {
         ImplGoogleSparseHash_s<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gdense:k") {
         ImplGoogleDenseHash<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "gdense_s:k") {
         ImplGoogleDenseHash_s<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell_s:k") {
         ImplBytell_s<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "libcuckoo.sa:k") {
         ImplLibCuckooSA<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "libcuckoo.ma:k") {
         ImplLibCuckooMA<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "folklore:k") {
         ImplGrowtFolklore<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "uaGrow:k") {
         ImplGrowtUAGrow<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "usGrow:k") {
         ImplGrowtUSGrow<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "usnGrow:k") {
         ImplGrowtUSNGrow<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "paGrow:k") {
         ImplGrowtPAGrow<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "psGrow:k") {
         ImplGrowtPSGrow<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "psnGrow:k") {
         ImplGrowtPSNGrow<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_LIBCDS
     } else if(htName == "michaelML:k") {
         ImplCDSMichaelMLNOGC<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "michaelMLMA:k") {
         ImplCDSMichaelMLNOGCMA<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "michaelMLSA:k") {
         ImplCDSMichaelMLNOGCSA<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "michaelMLDHP:k") {
         ImplCDSMichaelMLDHP<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 //    } else if(htName == "michaelLL:i") {
 //        ImplCDSMichaelLLNOGC<size_t, size_t> impl;
 //        TestInts::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
     } else if(htName == "skiplist:k") {
         ImplCDSSkipList<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "splitlist:k") {
         ImplCDSSplitList<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "splitlistMA:k") {
         ImplCDSSplitListMA<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR_FOLLY
     } else if(htName == "folly:k") {
         ImplFolly<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "follyQ:k") {
         ImplFollyQ<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "follyQMA:k") {
         ImplFollyQMA<size_t, size_t> impl;
         TestInts3::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
+#endif
 #endif
+#if HM_USE_OWN
+    } else if(htName == "ChainInts:z") {
+        ImplChainInts impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "Chain:z") {
+        ImplChain<size_t,size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainSlab:z") {
+        ImplChainSlab<size_t,size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainU:z") {
+        ImplChainGenericUB<size_t,size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainUV:z") {
+        ImplChainGenericUBVK<size_t,size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainV:z") {
+        ImplChainGenericV<size_t,size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainC7:z") {
+        ImplCacheChain<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainC0:z") {
+        ImplCacheChain2<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "CChain2C:z") {
+        ImplCacheChain2Config<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainC:z") {
+        ImplCacheChain3<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "CChain3AC:z") {
+        ImplCacheChain3AC<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainCV:z") {
+        ImplCacheChain3VK<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainCU:z") {
+        ImplCacheChain3UB<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainCUV:z") {
+        ImplCacheChain3UBVK<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChunkHT:z") {
+        ImplChunkHT impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "Mmap:z") {
+        ImplMmap<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapU:z") {
+        ImplMmapU<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapC:z") {
+        ImplMmapCache<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQ:z") {
+        ImplMmapQuad<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQC:z") {
+        ImplMmapQuadC<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQCU:z") {
+        ImplMmapQuadCU<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQCUV:z") {
+        ImplMmapQuadCUV<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQCUV0:z") {
+        ImplMmapQuadCUV0<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapMmap:z") {
+        ImplMmapMmap<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "InsituUF:z") {
+        ImplInsituU<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "InsituQUF:z") {
+        ImplInsituUBquad<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "InsituQ:z") {
+        ImplInsituQuad<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "InsituRevCasU:z") {
+        ImplInsituRevCasUB<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "InsituRevCasQU:z") {
+        ImplInsituRevCasUBquad<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "InsituDU:z") {
+        ImplInsituDCASUB<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "InsituQDU:z") {
+        ImplInsituDCASUBquad<size_t, size_t> impl;
+        TestSkewed::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_OWN
     } else if(htName == "Chain:s") {
         ImplChain<my_string,size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainSlab:s") {
         ImplChainSlab<my_string,size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainU:s") {
         ImplChainGenericUB<my_string,size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainUV:s") {
         ImplChainGenericUBVK<my_string,size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainUVS:s") {
+        ImplChainSplitUBVK<my_string,size_t> impl;
+        TestStrings::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
     } else if(htName == "ChainV:s") {
         ImplChainGenericV<my_string,size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC7:s") {
         ImplCacheChain<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC0:s") {
         ImplCacheChain2<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain2C:s") {
         ImplCacheChain2Config<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC:s") {
         ImplCacheChain3<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain3AC:s") {
         ImplCacheChain3AC<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCV:s") {
         ImplCacheChain3VK<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCU:s") {
         ImplCacheChain3UB<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCUV:s") {
         ImplCacheChain3UBVK<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Mmap:s") {
         ImplMmap<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapU:s") {
         ImplMmapU<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapC:s") {
         ImplMmapCache<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQ:s") {
         ImplMmapQuad<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQC:s") {
         ImplMmapQuadC<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCU:s") {
         ImplMmapQuadCU<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCUV:s") {
         ImplMmapQuadCUV<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQE:s") {
+        ImplMmapQuadE<my_string, size_t> impl;
+        TestStrings::Test<decltype(impl)> test;
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR
     } else if(htName == "ChunkHT:s") {
         ImplChunkHTGeneric<my_string> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "TBBF:s") {
         ImplTBBHashMapDefaultAllocator<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "bytell:s") {
         ImplBytell<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell_s:s") {
         ImplBytell_s<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "libcuckoo.sa:s") {
         ImplLibCuckooSA<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 //    } else if(htName == "Junction.s") {
 //        ImplJunction<my_string, size_t, junction::ConcurrentMap_Leapfrog> impl;
 //        TestStrings::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 #endif
 #if HM_USE_OWN
     } else if(htName == "Chain:w") {
         ImplChain<my_string,size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainSlab:w") {
         ImplChainSlab<my_string,size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 //        auto _words = WordData::getTestDataCache()[0]._words;
 //        auto _wordsTotal = WordData::getTestDataCache()[0]._wordsTotal;
 //        for(;_wordsTotal--;) {
@@ -2741,316 +3342,360 @@ void runTest(std::string const& htName) {
     } else if(htName == "ChainU:w") {
         ImplChainGenericUB<my_string,size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainUV:w") {
         ImplChainGenericUBVK<my_string,size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainUVS:w") {
+        ImplChainSplitUBVK<my_string,size_t> impl;
+        TestWords1<decltype(impl)> test;
+        runSelectedTest(test, impl);
     } else if(htName == "ChainV:w") {
         ImplChainGenericV<my_string,size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC7:w") {
         ImplCacheChain<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC0:w") {
         ImplCacheChain2<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain2C:w") {
         ImplCacheChain2Config<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC:w") {
         ImplCacheChain3<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain3AC:w") {
         ImplCacheChain3AC<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCV:w") {
         ImplCacheChain3VK<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCU:w") {
         ImplCacheChain3UB<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCUV:w") {
         ImplCacheChain3UBVK<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "Mmap:w") {
         ImplMmap<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapU:w") {
         ImplMmapU<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapC:w") {
         ImplMmapCache<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQ:w") {
         ImplMmapQuad<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQC:w") {
         ImplMmapQuadC<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCU:w") {
         ImplMmapQuadCU<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCUV:w") {
         ImplMmapQuadCUV<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQCUVX:w") {
+        ImplMmapQuadCUVX<my_string, size_t> impl;
+        TestWords1<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQE:w") {
+        ImplMmapQuadE<my_string, size_t> impl;
+        TestWords1<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainUVX:w") {
+        ImplChainGenericUBVKX<my_string, size_t> impl;
+        TestWords1<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "Intern:w") {
+        ImplIntern<my_string, size_t> impl;
+        TestWords1<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "Intern:m") {
+        ImplIntern<my_string_ref, size_t> impl;
+        TestWordsMapped<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainUV:m") {
+        ImplChainGenericUBVK<my_string_ref, size_t> impl;
+        TestWordsMapped<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainUVX:m") {
+        ImplChainGenericUBVKX<my_string_ref, size_t> impl;
+        TestWordsMapped<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "ChainCUV:m") {
+        ImplCacheChain3UBVK<my_string_ref, size_t> impl;
+        TestWordsMapped<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQCUV:m") {
+        ImplMmapQuadCUV<my_string_ref, size_t> impl;
+        TestWordsMapped<decltype(impl)> test;
+        runSelectedTest(test, impl);
+    } else if(htName == "MmapQCUVX:m") {
+        ImplMmapQuadCUVX<my_string_ref, size_t> impl;
+        TestWordsMapped<decltype(impl)> test;
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR
 #if HM_USE_VENDOR_TBB
     } else if(htName == "TBBF:w") {
         ImplTBBHashMapDefaultAllocator<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "bytell:w") {
         ImplBytell<my_string, size_t> impl;
         TestWords1<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell_s:w") {
         ImplBytell_s<my_string, size_t> impl;
         TestStrings::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "libcuckoo.sa:w") {
         ImplLibCuckooSA<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #endif
 #if HM_USE_OWN
     } else if(htName == "Chain:v") {
         ImplChain<myvector,size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainSlab:v") {
         ImplChainSlab<myvector,size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainU:v") {
         ImplChainGenericUB<myvector,size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainUV:v") {
         ImplChainGenericUBVK<myvector,size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainV:v") {
         ImplChainGenericV<myvector,size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC7:v") {
         ImplCacheChain<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC0:v") {
         ImplCacheChain2<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain2C:v") {
         ImplCacheChain2Config<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainC:v") {
         ImplCacheChain3<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "CChain3AC:v") {
         ImplCacheChain3AC<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCV:v") {
         ImplCacheChain3VK<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCU:v") {
         ImplCacheChain3UB<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "ChainCUV:v") {
         ImplCacheChain3UBVK<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 //    } else if(htName == "ChunkHT:v") {
 //        ImplChunkHT impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
     } else if(htName == "Mmap:v") {
         ImplMmap<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapU:v") {
         ImplMmapU<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapC:v") {
         ImplMmapCache<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQ:v") {
         ImplMmapQuad<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQC:v") {
         ImplMmapQuadC<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapQCU:v") {
         ImplMmapQuadCU<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "MmapQCUV:v") {
         ImplMmapQuadCUV<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_OWN
     } else if(htName == "OpenAddr:v") {
         ImplOpenAddr<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "GenHT:v") {
         ImplGenHT<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "MmapMmap:v") {
         ImplMmapMmap<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR
     } else if(htName == "dbsll:v") {
         ImplDBSLL<myvector> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "dbsllold:v") {
         ImplDBSLLOld<myvector> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #if HM_USE_VENDOR_TBB
     } else if(htName == "TBBF:v") {
         ImplTBBHashMapDefaultAllocator<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "TBBF.ma:v") {
         ImplTBBHashMapMyAllocator<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "TBBFu:v") {
         ImplTBBUnorderedMapDefaultAllocator<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "TBBF:sa:v") {
         ImplTBBHashMapScalableAllocator<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "TBBFu:sa:v") {
         ImplTBBUnorderedMapScalableAllocator<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #ifdef HAVE_DIVINE
     } else if(htName == "DIVINE:v") {
         ImplDivineHT<myvector> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
 #if HM_USE_VENDOR_TBB
     } else if(htName == "libcuckoo.sa:v") {
         ImplLibCuckooSA<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 #endif
     } else if(htName == "libcuckoo.ma:v") {
         ImplLibCuckooMA<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 //    } else if(htName == "Sylvan:v") {
 //        ImplSylvan<myvector, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "Junction.Crude:v") {
 //        ImplJunctionCrude<myvector, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "Junction.Linear:v") {
 //        ImplJunctionLinear<myvector, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "Junction.LeapFrog:v") {
 //        ImplJunctionLeapFrog<myvector, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "Junction.Grampa:v") {
 //        ImplJunctionGrampa<myvector, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
     } else if(htName == "bytell:v") {
         ImplBytell<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
     } else if(htName == "bytell_s:v") {
         ImplBytell_s<myvector, size_t> impl;
         TestVectors::Test<decltype(impl)> test;
-        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+        runSelectedTest(test, impl);
 //    } else if(htName == "gsparse:v") {
 //        ImplGoogleSparseHash<size_t, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "gsparse_s:v") {
 //        ImplGoogleSparseHash_s<size_t, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "gdense:v") {
 //        ImplGoogleDenseHash<size_t, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "gdense_s:v") {
 //        ImplGoogleDenseHash_s<size_t, size_t> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 #endif
 #if HM_USE_DTREE
 //    } else if(htName == "dtree:v") {
 //        ImplDTree<myvector, size_t, HashSet> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 
 //    } else if(htName == "dtreel:v") {
 //        ImplDTree<myvector, size_t, HashSet<RehasherExit, Linear>> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "dtreell:v") {
 //        ImplDTree<myvector, size_t, HashSet<RehasherExit, LinearLinear>> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "dtreeql:v") {
 //        ImplDTree<myvector, size_t, HashSet<RehasherExit, QuadLinear>> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "dtreeld8:v") {
 //        ImplDTree<myvector, size_t, HashSet<RehasherExit, LinearDiv8>> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 //    } else if(htName == "dtreeld2:v") {
 //        ImplDTree<myvector, size_t, HashSet<RehasherExit, LinearDiv2>> impl;
 //        TestVectors::Test<decltype(impl)> test;
-//        SimpleTest<decltype(test), decltype(impl)>(test, impl).test();
+//        runSelectedTest(test, impl);
 #endif
     } else if(!htName.empty()) {
         printf("Unknown hash map: %s\n", htName.c_str());
@@ -3069,25 +3714,24 @@ int main(int argc, char** argv) {
     settings["inserts"] = 100000;
     settings["buckets_scale"] = 28;
     settings["page_size_scale"] = 28;
+    settings["page_mode"] = "auto";
+    settings["prefault"] = 0;
+    settings["populate"] = 0;
     settings["stats"] = 0;
     settings["bars"] = 128;
-
-    std::cout << "\033[1m"
-              << std::fixed << std::setw( 25 ) << "name"
-              << std::fixed << std::setw(  4 ) << "scl"
-              << std::fixed << std::setw(  4 ) << "pss"
-              << std::fixed << std::setw(  4 ) << "ths"
-              << std::fixed << std::setw(  9 ) << "inserts"
-              << std::fixed << std::setw(  7 ) << "setup"
-              << std::fixed << std::setw(  7 ) << "insert"
-              << std::fixed << std::setw(  8 ) << "inssum"
-              << std::fixed << std::setw(  7 ) << "verify"
-              << std::fixed << std::setw(  8 ) << "vfysum"
-              << std::fixed << std::setw(  7 ) << "clean"
-              << std::fixed << std::setw(  7 ) << "total"
-              << std::endl
-              << "\033[0m"
-              ;
+    settings["mode"] = "simple";
+    settings["latency"] = 0;
+    settings["latency_sample"] = 8;
+    settings["perf"] = 0;
+    settings["memory"] = 0;
+    settings["record"] = "";
+    settings["trace"] = "";
+    settings["words"] = "../../words.txt";
+    settings["pin"] = "";
+    settings["cpus"] = "";
+    settings["repeat"] = 1;
+    settings["max_probes"] = 0;
+    settings["stash"] = 0;
 
     struct option long_options[] =
     {
@@ -3134,13 +3778,48 @@ int main(int argc, char** argv) {
         }
     }
 
+    Results::get().configure();
+
+    if(settingAsDouble("theta", 0.99) >= 1.0) {
+        std::cerr << "--theta must be below 1, the Zipfian generator needs 1/(1-theta)" << std::endl;
+        return 1;
+    }
+
+    if(Topology::get().pinning()) {
+        std::cout << Topology::get().describe() << std::endl;
+    }
+
+    if(settings["mode"].asString() == "simple") {
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "scl"
+                  << std::fixed << std::setw(  4 ) << "pss"
+                  << std::fixed << std::setw(  4 ) << "ths"
+                  << std::fixed << std::setw(  9 ) << "inserts"
+                  << std::fixed << std::setw(  7 ) << "setup"
+                  << std::fixed << std::setw(  7 ) << "insert"
+                  << std::fixed << std::setw(  8 ) << "inssum"
+                  << std::fixed << std::setw(  7 ) << "verify"
+                  << std::fixed << std::setw(  8 ) << "vfysum"
+                  << std::fixed << std::setw(  7 ) << "clean"
+                  << std::fixed << std::setw(  7 ) << "total"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
     int htindex = optind;
     while(argv[htindex]) {
         runTest(std::string(argv[htindex]) + ":" + settings["test"].asString());
         htindex++;
     }
 
+    Results::get().write();
+    if(Results::get().compare()) {
+        return 2;
+    }
+
 }
 
 //TLS<slab> SlabManager::_slab;
-__thread slab* SlabManager::_slab;
+__thread SlabManager::CachedSlab SlabManager::_threadCache[SlabManager::THREAD_CACHE_SLOTS];
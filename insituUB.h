@@ -10,8 +10,11 @@
 #include <new>
 
 #include "allocator.h"
+#include "casstats.h"
+#include "generation.h"
 #include "mmapper.h"
 #include "murmurhash.h"
+#include "probing.h"
 
 namespace insituUB {
 
@@ -30,26 +33,30 @@ public:
 /*
  * 16 bits hash, 48 bits key
  * 16 bits ..., 48 bits value
+ *
+ * With TAGS = GenerationTagged the top 8 bits of both hold the generation of
+ * the table and the hash has 8 bits, see generation.h.
  */
 
-template<typename K, typename V>
-class HashTable {
+template<typename K, typename V, typename TAGS = hashtables::Untagged>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_entriesPerBucket)
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask(_entries-1ULL)
+    , _probeLimit(hashtables::ProbeLimit::fromSettings(_entries))
     {
-        _map = (decltype(_map))MMapper::mmapForMap(_buckets * _bucketSize);
+        _map = (decltype(_map))MMapper::mmapForMap(mapBytes());
     }
 public:
 
     static size_t getHash(size_t ptr) {
-        return ((intptr_t)ptr & 0xFFFF000000000000ULL);
+        return ((intptr_t)ptr & TAGS::HASH_MASK);
     }
 
     static K getPtr(size_t ptr) {
@@ -61,6 +68,16 @@ public:
     }
 
     size_t insert(K const& key, V const& value) {
+        V result;
+        tryInsert(key, value, result);
+        return result;
+    }
+
+    /**
+     * Inserts key unless it is there already. result is the value in the
+     * table afterwards, or value if the table is FULL, see probing.h.
+     */
+    hashtables::InsertResult tryInsert(K const& key, V const& value, V& result) {
 //        printf("key:   %zx\n", key);
         size_t h = hash(key);
         size_t h16l = hash16LeftFromHash(h);
@@ -68,15 +85,22 @@ public:
 //        printf("entry: %zx\n", e);
         HashTableEntry<K,V>* current = &_map[e];
 //        printf("cur:   %p\n", current);
+        hashtables::Probe probe(_probeLimit, _entries);
 
+        size_t const tag = _tags.tag();
         size_t oldKey;
-        size_t newKey = key | h16l;
+        size_t newKey = key | h16l | tag;
+        CasStats::Op cas;
         do {
             oldKey = 0ULL;
             while(true) {
                 size_t kAndHash = current->_key.load(std::memory_order_relaxed);
                 //printf("checking existing entry: %zx\n", kAndHash); fflush(stdout);
                 if(kAndHash == 0ULL) break;
+                if(!_tags.isLive(kAndHash)) {
+                    oldKey = kAndHash;
+                    break;
+                }
                 size_t currentHash = getHash(kAndHash);
                 K k = getPtr(kAndHash);
                 if(currentHash == h16l) {
@@ -84,17 +108,24 @@ public:
                         std::atomic_thread_fence(std::memory_order_acquire);
                         while(true) {
                             size_t v = current->_value.load(std::memory_order_relaxed);
-                            if(v) return v;
+                            if(_tags.isLive(v)) {
+                                result = TAGS::untag(v);
+                                return hashtables::InsertResult::FOUND;
+                            }
                             _mm_pause();
                         }
                     }
                 }
-                e = (e+1) & _entriesMask;
+                if(!probe.next(e, [this, e]() { return (e+1) & _entriesMask; })) {
+                    result = value;
+                    return hashtables::InsertResult::FULL;
+                }
                 current = &_map[e];
             }
-        } while(!current->_key.compare_exchange_strong(oldKey, newKey, std::memory_order_release, std::memory_order_relaxed));
-        current->_value.store(value, std::memory_order_relaxed);
-        return value;
+        } while(!cas.strong(current->_key, oldKey, newKey, std::memory_order_release, std::memory_order_relaxed));
+        current->_value.store(value | tag, std::memory_order_relaxed);
+        result = value;
+        return hashtables::InsertResult::INSERTED;
     }
 
     bool get(K const& key, V& value) {
@@ -104,11 +135,12 @@ public:
 //        printf("entry: %zx\n", e);
         HashTableEntry<K,V>* current = &_map[e];
 //        printf("cur:   %p\n", current);
+        hashtables::Probe probe(_probeLimit, _entries);
 
         while(true) {
 //            printf("checking existing entry: %zx -> %zx\n", current->_key, current->_value);
             size_t kAndHash = current->_key.load(std::memory_order_relaxed);
-            if(kAndHash == 0ULL) break;
+            if(!_tags.isLive(kAndHash)) break;
 
             size_t currentHash = getHash(kAndHash);
             K k = getPtr(kAndHash);
@@ -117,15 +149,15 @@ public:
                     std::atomic_thread_fence(std::memory_order_acquire);
                     while(true) {
                         size_t v = current->_value.load(std::memory_order_relaxed);
-                        if(v) {
-                            value = v;
+                        if(_tags.isLive(v)) {
+                            value = TAGS::untag(v);
                             return true;
                         }
                         _mm_pause();
                     }
                 }
             }
-            e = (e+1) & _entriesMask;
+            if(!probe.next(e, [this, e]() { return (e+1) & _entriesMask; })) break;
             current = &_map[e];
         }
 
@@ -135,7 +167,7 @@ public:
     size_t hash16LeftFromHash(size_t h) const {
 //        h ^= h << 32ULL;
 //        h ^= h << 16ULL;
-        return h & 0xFFFF000000000000ULL;
+        return h & TAGS::HASH_MASK;
     }
 
     size_t entryFromhash(size_t const& h) {
@@ -173,6 +205,19 @@ public:
         printf("size = %zu\n", size());
     }
 
+    /**
+     * Empties the table, in O(1) if it is GenerationTagged, see
+     * generation.h. Must not run concurrently with other operations on the
+     * table.
+     */
+    void clear() {
+        _tags.clear(_map, mapBytes());
+    }
+
+    bool isLive(HashTableEntry<K,V> const& entry) const {
+        return _tags.isLive(entry._key.load(std::memory_order_relaxed));
+    }
+
     void thread_init() {
         _slabManager.thread_init();
     }
@@ -181,8 +226,12 @@ public:
         return new(_slabManager.alloc<HashTableEntry<K,V>>()) HashTableEntry<K,V>(key, value);
     }
 
-    ~HashTable() {
-        munmap(_map, _buckets * _bucketSize);
+    ~BasicHashTable() {
+        munmap(_map, mapBytes());
+    }
+
+    size_t mapBytes() const {
+        return _buckets * _bucketSize + _probeLimit.stashSlots * sizeof(HashTableEntry<K,V>);
     }
 
     template<typename CONTAINER>
@@ -199,7 +248,7 @@ public:
                 size_t bucketSize = 0;
 
                 for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                    if(_map[idx+b]._key.load(std::memory_order_relaxed)) {
+                    if(isLive(_map[idx+b])) {
                         bucketSize++;
                     }
                 }
@@ -232,7 +281,7 @@ public:
             size_t bucketSize = 0;
 
             for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                if(_map[idx+b]._key.load(std::memory_order_relaxed)) {
+                if(isLive(_map[idx+b])) {
                     bucketSize++;
                 }
             }
@@ -257,7 +306,9 @@ private:
     size_t const _bucketsMask;
     size_t const _entries;
     size_t const _entriesMask;
+    hashtables::ProbeLimit const _probeLimit;
     HashTableEntry<K,V>* _map;
+    TAGS _tags;
     SlabManager _slabManager;
 
 private:
@@ -265,4 +316,10 @@ private:
     static size_t constexpr _entriesPerBucket = _bucketSize/(sizeof(HashTableEntry<K, V>));
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::Untagged>;
+
+template<typename K, typename V>
+using GenerationTaggedHashTable = BasicHashTable<K, V, hashtables::GenerationTagged>;
+
 }
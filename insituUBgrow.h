@@ -0,0 +1,441 @@
+#pragma once
+
+// insituUB that grows: keys and values live in the slots as in insituUB, but
+// the table starts small and doubles, with all threads helping to migrate, in
+// the style of growt's uaGrow.
+//
+// Key slot: 1 bit MARKED, 1 bit OCCUPIED, 14 bits hash, 48 bits key
+// Value slot: 1 bit SET, 15 bits unused, 48 bits value
+//
+// The table grows when the inserts, counted on a 1/64 sample of the keys,
+// pass --grow_load (default 0.6) of the slots, or when an insert runs out of
+// probes (--max_probes, see probing.h) once they passed half of that; below
+// it tryInsert() reports FULL, as it does once the table is at MAX_SCALE.
+// The first thread to notice maps an array twice the size. From then on the old array is migrated in blocks of
+// BLOCK_ENTRIES slots, which the threads claim one by one. A migrating thread
+// marks every slot with a CAS before copying it, so no insert can take a slot
+// that was already copied, and a marked empty slot closes its cluster.
+// Blocks are cluster aligned as in growt: a block starts at its first empty
+// slot, the slots before it belong to the cluster of the block in front, and
+// runs on past its end until it has closed an empty slot.
+//
+// Inserts that see a migration, or a marked slot, help migrating and then
+// retry on the new array once the last block is done and it took over, so
+// only migrating threads write the new array before that. Lookups never wait:
+// a marked slot still holds its key, and a lookup that reaches a marked empty
+// slot continues in the next array. Copies stay within the probe limit of the
+// next array; one that does not fit raises that limit for all operations on
+// the array, so no key gets out of reach.
+//
+// Lookups may still be reading an old array after the handover, so old arrays
+// are only unmapped by reclaim(), which must not run concurrently with other
+// operations, or by the destructor. Until then they take at most as much
+// memory as the current array. There is no clear().
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <xmmintrin.h>
+
+#include "mmapper.h"
+#include "murmurhash.h"
+#include "probing.h"
+
+namespace insituUBgrow {
+
+class HashTableEntry {
+public:
+    std::atomic<size_t> _key;
+    std::atomic<size_t> _value;
+};
+
+template<typename K, typename V>
+class HashTable {
+public:
+
+    static constexpr size_t MARKED = 0x8000000000000000ULL;
+    static constexpr size_t OCCUPIED = 0x4000000000000000ULL;
+    static constexpr size_t HASH_MASK = 0x3FFF000000000000ULL;
+    static constexpr size_t PTR_MASK = 0x0000FFFFFFFFFFFFULL;
+    static constexpr size_t VALUE_SET = 0x8000000000000000ULL;
+
+    static constexpr size_t BLOCK_ENTRIES = 4096;
+    static constexpr size_t SAMPLE_BITS = 6;
+    static constexpr size_t MAX_SCALE = 32;
+
+    HashTable(size_t bucketsScale)
+    : _maxLoad(maxLoadFromSettings())
+    , _current(new Array(bucketsScale, _maxLoad))
+    {
+    }
+
+    HashTable(HashTable const&) = delete;
+    HashTable& operator=(HashTable const&) = delete;
+
+    ~HashTable() {
+        Array* array = _current.load(std::memory_order_relaxed);
+        delete array->next.load(std::memory_order_relaxed);
+        delete array;
+        reclaim();
+    }
+
+    static K getPtr(size_t ptr) {
+        return (K)(ptr & PTR_MASK);
+    }
+
+    size_t hash(K const& key) {
+        return MurmurHash64(key);
+    }
+
+    size_t insert(K const& key, V const& value) {
+        V result;
+        tryInsert(key, value, result);
+        return result;
+    }
+
+    /**
+     * Inserts key unless it is there already. result is the value in the
+     * table afterwards, or value if the table is FULL: there is no free slot
+     * within the probe limit and the table is at MAX_SCALE or below half of
+     * --grow_load.
+     */
+    hashtables::InsertResult tryInsert(K const& key, V const& value, V& result) {
+        size_t h = hash(key);
+        size_t newKey = (size_t)key | (h & HASH_MASK) | OCCUPIED;
+        while(true) {
+            Array* array = _current.load(std::memory_order_acquire);
+            if(__builtin_expect(array->next.load(std::memory_order_acquire) != nullptr, 0)) {
+                helpMigrate(array);
+                continue;
+            }
+            switch(insertInto(*array, h, newKey, value, result)) {
+                case Outcome::INSERTED:
+                    if(count(*array, h)) startGrowth(array, array->growAt);
+                    return hashtables::InsertResult::INSERTED;
+                case Outcome::FOUND:
+                    return hashtables::InsertResult::FOUND;
+                case Outcome::MOVED:
+                    helpMigrate(array);
+                    break;
+                case Outcome::FULL:
+                    if(!startGrowth(array, array->growAt / 2)) {
+                        result = value;
+                        return hashtables::InsertResult::FULL;
+                    }
+                    break;
+            }
+        }
+    }
+
+    bool get(K const& key, V& value) {
+        size_t h = hash(key);
+        size_t wanted = (size_t)key | (h & HASH_MASK) | OCCUPIED;
+        Array* array = _current.load(std::memory_order_acquire);
+        while(array) {
+            size_t e = h & array->mask;
+            size_t maxProbes = array->maxProbes.load(std::memory_order_relaxed);
+            for(size_t p = 0; p < maxProbes; ++p, e = (e+1) & array->mask) {
+                HashTableEntry& slot = array->slots[e];
+                size_t k = slot._key.load(std::memory_order_acquire);
+                if(!(k & OCCUPIED)) {
+                    if(!(k & MARKED)) return false;
+                    break;
+                }
+                if((k & ~MARKED) == wanted) {
+                    value = waitForValue(slot);
+                    return true;
+                }
+            }
+            array = array->next.load(std::memory_order_acquire);
+        }
+        return false;
+    }
+
+    void thread_init() {
+    }
+
+    /**
+     * Unmaps the arrays that were migrated. Must not run concurrently with
+     * other operations on the table.
+     */
+    void reclaim() {
+        std::lock_guard<std::mutex> lock(_retiredLock);
+        for(Array* array: _retired) {
+            delete array;
+        }
+        _retired.clear();
+    }
+
+    size_t bucketsScale() const {
+        return _current.load(std::memory_order_acquire)->scale;
+    }
+
+    size_t growths() {
+        std::lock_guard<std::mutex> lock(_retiredLock);
+        return _growths;
+    }
+
+    struct stats {
+        size_t size;
+        size_t usedBuckets;
+        size_t collisions;
+        size_t biggestBucket;
+        double avgBucketSize;
+    };
+
+    /**
+     * Counts the current array in buckets of a cache line, as insituUB does.
+     */
+    void getStats(stats& s) {
+        s.size = 0;
+        s.usedBuckets = 0;
+        s.collisions = 0;
+        s.biggestBucket = 0;
+        s.avgBucketSize = 0.0;
+
+        Array* array = _current.load(std::memory_order_acquire);
+        size_t buckets = 0;
+        for(size_t idx = 0; idx < array->entries; idx += _entriesPerBucket) {
+            size_t bucketSize = 0;
+
+            for(size_t b = 0; b < _entriesPerBucket && idx + b < array->entries; ++b) {
+                if(array->slots[idx+b]._key.load(std::memory_order_relaxed) & OCCUPIED) {
+                    bucketSize++;
+                }
+            }
+
+            if(bucketSize > 0) {
+                s.usedBuckets++;
+                s.size += bucketSize;
+                s.collisions += bucketSize - 1;
+                if(bucketSize > s.biggestBucket) s.biggestBucket = bucketSize;
+            }
+            buckets++;
+        }
+
+        if(buckets > 0) {
+            s.avgBucketSize = (double)s.size / (double)buckets;
+        }
+    }
+
+private:
+
+    enum class Outcome {
+        INSERTED,
+        FOUND,
+        FULL,   // no free slot within the probe limit
+        MOVED,  // ran into a slot a migration had marked
+    };
+
+    struct Array {
+
+        Array(size_t scale_, double maxLoad)
+        : scale(scale_)
+        , entries(1ULL << scale)
+        , mask(entries - 1ULL)
+        , maxProbes(hashtables::ProbeLimit::fromSettings(entries).maxProbes)
+        , blocks((entries + BLOCK_ENTRIES - 1) / BLOCK_ENTRIES)
+        , growAt(entries * maxLoad)
+        , slots((HashTableEntry*)MMapper::mmapForMap(entries * sizeof(HashTableEntry)))
+        , next(nullptr)
+        , growing(false)
+        , sampledInserts(0)
+        , nextBlock(0)
+        , blocksDone(0)
+        {
+        }
+
+        ~Array() {
+            MMapper::munmap(slots, entries * sizeof(HashTableEntry));
+        }
+
+        size_t const scale;
+        size_t const entries;
+        size_t const mask;
+        std::atomic<size_t> maxProbes;  // only raised by migrating threads
+        size_t const blocks;
+        size_t const growAt;
+        HashTableEntry* const slots;
+        std::atomic<Array*> next;
+        std::atomic<bool> growing;
+
+        // Written while the table is in use, so kept off the line above
+        char padding0[64];
+        std::atomic<size_t> sampledInserts;
+        char padding1[64];
+        std::atomic<size_t> nextBlock;
+        std::atomic<size_t> blocksDone;
+        char padding2[64];
+    };
+
+    static double maxLoadFromSettings() {
+        std::string load = Settings::global()["grow_load"].asString();
+        return load.empty() ? 0.6 : std::stod(load);
+    }
+
+    static V waitForValue(HashTableEntry& slot) {
+        size_t v;
+        while(!((v = slot._value.load(std::memory_order_acquire)) & VALUE_SET)) {
+            _mm_pause();
+        }
+        return (V)(v & PTR_MASK);
+    }
+
+    __attribute__((always_inline))
+    Outcome insertInto(Array& array, size_t h, size_t newKey, V const& value, V& result) {
+        size_t e = h & array.mask;
+        size_t maxProbes = array.maxProbes.load(std::memory_order_relaxed);
+        for(size_t p = 0; p < maxProbes; ++p, e = (e+1) & array.mask) {
+            HashTableEntry& slot = array.slots[e];
+            size_t k = slot._key.load(std::memory_order_relaxed);
+            if(!(k & OCCUPIED)) {
+                if(k & MARKED) return Outcome::MOVED;
+                if(slot._key.compare_exchange_strong(k, newKey, std::memory_order_release, std::memory_order_relaxed)) {
+                    slot._value.store((size_t)value | VALUE_SET, std::memory_order_release);
+                    result = value;
+                    return Outcome::INSERTED;
+                }
+                if(!(k & OCCUPIED)) return Outcome::MOVED;
+            }
+            if((k & ~MARKED) == newKey) {
+                result = waitForValue(slot);
+                return Outcome::FOUND;
+            }
+        }
+        return Outcome::FULL;
+    }
+
+    /**
+     * Counts an insert into array if h is in the sample. Returns whether the
+     * array is over its load.
+     */
+    __attribute__((always_inline))
+    bool count(Array& array, size_t h) {
+        // Mixed first: MurmurHash64 of an integer is the integer itself
+        if((h * 0x9E3779B97F4A7C15ULL) >> (64 - SAMPLE_BITS)) return false;
+        size_t n = array.sampledInserts.fetch_add(1, std::memory_order_relaxed) + 1;
+        return (n << SAMPLE_BITS) > array.growAt;
+    }
+
+    /**
+     * Maps the next array unless another thread already did, then helps
+     * migrating. Only the current array grows, and only if its sampled
+     * inserts passed floor. Returns false if array does not grow.
+     */
+    __attribute__((noinline))
+    bool startGrowth(Array* array, size_t floor) {
+        if(_current.load(std::memory_order_acquire) != array) return true;
+        if(!array->growing.load(std::memory_order_acquire)) {
+            if(array->scale >= MAX_SCALE) return false;
+            if((array->sampledInserts.load(std::memory_order_relaxed) << SAMPLE_BITS) <= floor) return false;
+            bool expected = false;
+            if(array->growing.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                array->next.store(new Array(array->scale + 1, _maxLoad), std::memory_order_release);
+            }
+        }
+        helpMigrate(array);
+        return true;
+    }
+
+    /**
+     * Migrates blocks of array until none are left, then waits until the
+     * next array took over. The thread that finishes the last block hands
+     * over.
+     */
+    __attribute__((noinline))
+    void helpMigrate(Array* array) {
+        Array* next;
+        while(!(next = array->next.load(std::memory_order_acquire))) {
+            _mm_pause();
+        }
+        size_t block;
+        while((block = array->nextBlock.fetch_add(1, std::memory_order_relaxed)) < array->blocks) {
+            migrateBlock(*array, *next, block);
+            if(array->blocksDone.fetch_add(1, std::memory_order_acq_rel) + 1 == array->blocks) {
+                {
+                    std::lock_guard<std::mutex> lock(_retiredLock);
+                    _retired.push_back(array);
+                    _growths++;
+                }
+                _current.store(next, std::memory_order_release);
+            }
+        }
+        while(_current.load(std::memory_order_acquire) == array) {
+            _mm_pause();
+        }
+    }
+
+    void migrateBlock(Array& from, Array& to, size_t block) {
+        size_t begin = block * BLOCK_ENTRIES;
+        size_t end = std::min(begin + BLOCK_ENTRIES, from.entries);
+
+        // The slots before the first empty one are the end of a cluster that
+        // started in an earlier block. Block 0 takes them anyway, so a table
+        // without any empty slot is migrated as well.
+        size_t first = begin;
+        while(block != 0 && first < end && (from.slots[first]._key.load(std::memory_order_relaxed) & OCCUPIED)) {
+            first++;
+        }
+        if(first == end) return;
+
+        for(size_t i = first; i < first + from.entries; ++i) {
+            bool closed = migrateSlot(from, to, i & from.mask);
+            if(closed && i >= end) break;
+        }
+    }
+
+    /**
+     * Marks slot e of from and copies its entry to to. Returns whether the
+     * slot is a marked empty slot, closing its cluster.
+     */
+    bool migrateSlot(Array& from, Array& to, size_t e) {
+        HashTableEntry& slot = from.slots[e];
+        size_t k = slot._key.load(std::memory_order_relaxed);
+        do {
+            if(k & MARKED) return !(k & OCCUPIED);
+        } while(!slot._key.compare_exchange_weak(k, k | MARKED, std::memory_order_acq_rel, std::memory_order_relaxed));
+        if(!(k & OCCUPIED)) return true;
+        moveInto(to, k, waitForValue(slot));
+        return false;
+    }
+
+    /**
+     * Copies an entry into an array that is not current yet. Only migrating
+     * threads write there and every key comes from one marked slot, so this
+     * does not look for the key. The array is twice the size of the one
+     * migrated, so there is a free slot; if it is past the probe limit, the
+     * limit is raised to it before the handover publishes the array.
+     */
+    void moveInto(Array& to, size_t k, V const& value) {
+        size_t h = hash(getPtr(k));
+        size_t e = h & to.mask;
+        for(size_t p = 1;; ++p, e = (e+1) & to.mask) {
+            HashTableEntry& slot = to.slots[e];
+            size_t expected = 0;
+            if(slot._key.load(std::memory_order_relaxed) == 0
+            && slot._key.compare_exchange_strong(expected, k, std::memory_order_release, std::memory_order_relaxed)) {
+                size_t maxProbes = to.maxProbes.load(std::memory_order_relaxed);
+                while(maxProbes < p && !to.maxProbes.compare_exchange_weak(maxProbes, p, std::memory_order_relaxed)) {
+                }
+                slot._value.store((size_t)value | VALUE_SET, std::memory_order_release);
+                count(to, h);
+                return;
+            }
+        }
+    }
+
+private:
+    double const _maxLoad;
+    std::atomic<Array*> _current;
+    std::mutex _retiredLock;
+    std::vector<Array*> _retired;
+    size_t _growths = 0;
+
+private:
+    static size_t constexpr _entriesPerBucket = 64 / sizeof(HashTableEntry);
+};
+
+}
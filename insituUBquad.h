@@ -10,6 +10,7 @@
 #include <new>
 
 #include "allocator.h"
+#include "generation.h"
 #include "mmapper.h"
 #include "murmurhash.h"
 
@@ -30,14 +31,17 @@ public:
 /*
  * 16 bits hash, 48 bits key
  * 16 bits ..., 48 bits value
+ *
+ * With TAGS = GenerationTagged the top 8 bits of both hold the generation of
+ * the table and the hash has 8 bits, see generation.h.
  */
 
-template<typename K, typename V>
-class HashTable {
+template<typename K, typename V, typename TAGS = hashtables::Untagged>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_entriesPerBucket)
     , _bucketsMask((_buckets-1ULL))
@@ -49,7 +53,7 @@ public:
 public:
 
     static size_t getHash(size_t ptr) {
-        return ((intptr_t)ptr & 0xFFFF000000000000ULL);
+        return ((intptr_t)ptr & TAGS::HASH_MASK);
     }
 
     static K getPtr(size_t ptr) {
@@ -72,14 +76,19 @@ public:
         size_t eFirst = e;
         size_t inc = 1;
 
+        size_t const tag = _tags.tag();
         size_t oldKey;
-        size_t newKey = key | h16l;
+        size_t newKey = key | h16l | tag;
         do {
             oldKey = 0ULL;
             while(true) {
                 size_t kAndHash = current->_key.load(std::memory_order_relaxed);
                 //printf("checking existing entry: %zx\n", kAndHash); fflush(stdout);
                 if(kAndHash == 0ULL) break;
+                if(!_tags.isLive(kAndHash)) {
+                    oldKey = kAndHash;
+                    break;
+                }
                 size_t currentHash = getHash(kAndHash);
                 K k = getPtr(kAndHash);
                 if(currentHash == h16l) {
@@ -87,7 +96,7 @@ public:
                         std::atomic_thread_fence(std::memory_order_acquire);
                         while(true) {
                             size_t v = current->_value.load(std::memory_order_relaxed);
-                            if(v) return v;
+                            if(_tags.isLive(v)) return TAGS::untag(v);
                             _mm_pause();
                         }
                     }
@@ -97,7 +106,7 @@ public:
                 current = &_map[e];
             }
         } while(!current->_key.compare_exchange_strong(oldKey, newKey, std::memory_order_release, std::memory_order_relaxed));
-        current->_value.store(value, std::memory_order_relaxed);
+        current->_value.store(value | tag, std::memory_order_relaxed);
         return value;
     }
 
@@ -115,7 +124,7 @@ public:
         while(true) {
 //            printf("checking existing entry: %zx -> %zx\n", current->_key, current->_value);
             size_t kAndHash = current->_key.load(std::memory_order_relaxed);
-            if(kAndHash == 0ULL) break;
+            if(!_tags.isLive(kAndHash)) break;
 
             size_t currentHash = getHash(kAndHash);
             K k = getPtr(kAndHash);
@@ -124,8 +133,8 @@ public:
                     std::atomic_thread_fence(std::memory_order_acquire);
                     while(true) {
                         size_t v = current->_value.load(std::memory_order_relaxed);
-                        if(v) {
-                            value = v;
+                        if(_tags.isLive(v)) {
+                            value = TAGS::untag(v);
                             return true;
                         }
                         _mm_pause();
@@ -143,7 +152,7 @@ public:
     size_t hash16LeftFromHash(size_t h) const {
 //        h ^= h << 32ULL;
 //        h ^= h << 16ULL;
-        return h & 0xFFFF000000000000ULL;
+        return h & TAGS::HASH_MASK;
     }
 
     size_t entryFromhash(size_t const& h) {
@@ -181,6 +190,19 @@ public:
         printf("size = %zu\n", size());
     }
 
+    /**
+     * Empties the table, in O(1) if it is GenerationTagged, see
+     * generation.h. Must not run concurrently with other operations on the
+     * table.
+     */
+    void clear() {
+        _tags.clear(_map, _buckets * _bucketSize);
+    }
+
+    bool isLive(HashTableEntry<K,V> const& entry) const {
+        return _tags.isLive(entry._key.load(std::memory_order_relaxed));
+    }
+
     void thread_init() {
         _slabManager.thread_init();
     }
@@ -189,7 +211,7 @@ public:
         return new(_slabManager.alloc<HashTableEntry<K,V>>()) HashTableEntry<K,V>(key, value);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -207,7 +229,7 @@ public:
                 size_t bucketSize = 0;
 
                 for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                    if(_map[idx+b]._key.load(std::memory_order_relaxed)) {
+                    if(isLive(_map[idx+b])) {
                         bucketSize++;
                     }
                 }
@@ -240,7 +262,7 @@ public:
             size_t bucketSize = 0;
 
             for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                if(_map[idx+b]._key.load(std::memory_order_relaxed)) {
+                if(isLive(_map[idx+b])) {
                     bucketSize++;
                 }
             }
@@ -266,6 +288,7 @@ private:
     size_t const _entries;
     size_t const _entriesMask;
     HashTableEntry<K,V>* _map;
+    TAGS _tags;
     SlabManager _slabManager;
 
 private:
@@ -273,4 +296,10 @@ private:
     static size_t constexpr _entriesPerBucket = _bucketSize/(sizeof(HashTableEntry<K, V>));
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::Untagged>;
+
+template<typename K, typename V>
+using GenerationTaggedHashTable = BasicHashTable<K, V, hashtables::GenerationTagged>;
+
 }
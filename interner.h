@@ -0,0 +1,119 @@
+#pragma once
+
+// Concurrent string interning: every distinct key gets a dense 32-bit id,
+// 0, 1, 2, ... in the order in which the keys were first interned, and the
+// bytes of a key can be looked up by its id.
+//
+// The keys live in a chaintableUBVK table, so their bytes are copied once
+// into its slabs and stay at the same address for as long as the interner
+// lives. Its entries map a key to its id. A new entry is linked with the id
+// PENDING; only the thread whose entry got linked draws the next id, so no
+// ids are lost to threads racing for the same key. That thread fills in the
+// reverse slot of the id and then publishes the id in the entry. Threads
+// that find an entry that is still PENDING wait for the id to appear.
+//
+// Tables keyed on the ids can then use 4-byte keys, or plain arrays indexed
+// by id, instead of the strings.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <xmmintrin.h>
+
+#include "chaintableUBVK.h"
+#include "mmapper.h"
+
+template<typename K>
+class StringInterner {
+public:
+
+    static constexpr uint32_t PENDING = 0xFFFFFFFFU;
+    static constexpr uint32_t NONE = 0xFFFFFFFEU;
+
+    using Table = chaintablegenericUBVK::HashTable<K, uint32_t>;
+    using HTE = typename Table::HTE;
+
+    /**
+     * The table gets 2^bucketsScale buckets and up to 2^bucketsScale keys get
+     * an id, at most NONE of them.
+     */
+    StringInterner(size_t bucketsScale)
+    : _table(bucketsScale)
+    , _maxIds(std::min(1ULL << bucketsScale, (unsigned long long)NONE))
+    , _nextId(0)
+    , _byId(nullptr)
+    {
+        _byId = (decltype(_byId))MMapper::mmapForMap(_maxIds * sizeof(std::atomic<HTE*>));
+    }
+
+    ~StringInterner() {
+        MMapper::munmap(_byId, _maxIds * sizeof(std::atomic<HTE*>));
+    }
+
+    void thread_init() {
+        _table.thread_init();
+    }
+
+    /**
+     * Returns the id of key, giving it the next id if it has none yet.
+     * Returns NONE if it has none and all ids are taken.
+     */
+    uint32_t intern(K const& key) {
+        bool inserted;
+        HTE* hte = _table.findOrInsert(key, PENDING, inserted);
+        if(inserted) {
+            size_t id = _nextId.fetch_add(1, std::memory_order_relaxed);
+            if(id >= _maxIds) {
+                _nextId.store(_maxIds, std::memory_order_relaxed);
+                id = NONE;
+            } else {
+                _byId[id].store(hte, std::memory_order_release);
+            }
+            __atomic_store_n(&hte->_value, (uint32_t)id, __ATOMIC_RELEASE);
+            return id;
+        }
+        uint32_t id;
+        while((id = __atomic_load_n(&hte->_value, __ATOMIC_ACQUIRE)) == PENDING) {
+            _mm_pause();
+        }
+        return id;
+    }
+
+    /**
+     * Looks up the id of key without interning it. A key that another thread
+     * is interning right now may not be found yet.
+     */
+    bool find(K const& key, uint32_t& id) {
+        HTE* hte = _table.findEntry(key);
+        if(!hte) return false;
+        id = __atomic_load_n(&hte->_value, __ATOMIC_ACQUIRE);
+        return id < NONE;
+    }
+
+    /**
+     * Looks up the bytes of the key with the given id. They stay valid for
+     * as long as the interner lives. Ids of which the intern() call has not
+     * returned yet may not be found yet.
+     */
+    bool lookup(uint32_t id, const char*& data, size_t& length) const {
+        if(id >= size()) return false;
+        HTE* hte = _byId[id].load(std::memory_order_acquire);
+        if(!hte) return false;
+        data = hte->_key.data();
+        length = hte->_key.length();
+        return true;
+    }
+
+    /**
+     * The number of ids given out.
+     */
+    size_t size() const {
+        return std::min(_nextId.load(std::memory_order_relaxed), _maxIds);
+    }
+
+private:
+    Table _table;
+    size_t const _maxIds;
+    std::atomic<size_t> _nextId;
+    std::atomic<HTE*>* _byId;
+};
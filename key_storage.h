@@ -0,0 +1,94 @@
+#pragma once
+
+// How the variable-length key tables keep the bytes of their keys.
+//
+// CopiedKeys copies the bytes key_accessor gives into the entry, behind its
+// fixed part, so an entry does not depend on the key it was inserted with.
+//
+// ExternalKeys stores only the pointer and the length: the entry refers to
+// the bytes of the inserted key, which must stay valid and unchanged for as
+// long as the table lives. That rules out keys that hold their bytes
+// themselves, like integers, whose key_accessor points into the argument of
+// insert(). Meant for keys that point into data that outlives the table
+// anyway, like my_string_ref into a mapped input file, where it saves the
+// copy and keeps the entries at a fixed size.
+
+#include <cstddef>
+#include <cstring>
+
+namespace hashtables {
+
+struct CopiedKeys {
+};
+
+struct ExternalKeys {
+};
+
+/**
+ * The key part of an entry, which must be its last member. extraBytes() is
+ * what the entry needs beyond its sizeof().
+ */
+template<typename KEYS>
+class KeyStorage;
+
+template<>
+class KeyStorage<CopiedKeys> {
+public:
+
+    static size_t extraBytes(size_t length) {
+        return length;
+    }
+
+    KeyStorage(size_t length, const char* keyData): _length(length) {
+        memmove(_keyData, keyData, length);
+    }
+
+    bool matches(size_t length, const char* keyData) const {
+        if( _length != length) return false;
+        return !memcmp(_keyData, keyData, length);
+    }
+
+    size_t length() const {
+        return _length;
+    }
+
+    const char* data() const {
+        return _keyData;
+    }
+
+private:
+    size_t _length;
+    char _keyData[0];
+};
+
+template<>
+class KeyStorage<ExternalKeys> {
+public:
+
+    static size_t extraBytes(size_t length) {
+        (void)length;
+        return 0;
+    }
+
+    KeyStorage(size_t length, const char* keyData): _length(length), _keyData(keyData) {
+    }
+
+    bool matches(size_t length, const char* keyData) const {
+        if( _length != length) return false;
+        return _keyData == keyData || !memcmp(_keyData, keyData, length);
+    }
+
+    size_t length() const {
+        return _length;
+    }
+
+    const char* data() const {
+        return _keyData;
+    }
+
+private:
+    size_t _length;
+    const char* _keyData;
+};
+
+}
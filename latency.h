@@ -0,0 +1,298 @@
+#pragma once
+
+// Per-operation latency, enabled with --latency=1.
+//
+// ImplLatency wraps any Impl* and times every --latency_sample'th insert()
+// and get() of each thread with rdtscp. Samples go into per-thread
+// log-linear histograms (HDR style: 2^SUB_BUCKET_BITS linear sub-buckets per
+// power of two, so about 3% relative error). They are merged at the end of
+// each phase and printed as p50/p90/p99/p99.9/max in nanoseconds after the
+// result line of the driver.
+
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "driver.h"
+#include "results.h"
+
+class LatencyHistogram {
+public:
+
+    static constexpr size_t SUB_BUCKET_BITS = 5;
+    static constexpr size_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram()
+    : _counts(BUCKETS, 0)
+    , _max(0)
+    , _samples(0)
+    {
+    }
+
+    __attribute__((always_inline))
+    void record(uint64_t v) {
+        _counts[indexOf(v)]++;
+        _max = std::max(_max, v);
+        _samples++;
+    }
+
+    void merge(LatencyHistogram const& other) {
+        for(size_t i = 0; i < BUCKETS; ++i) _counts[i] += other._counts[i];
+        _max = std::max(_max, other._max);
+        _samples += other._samples;
+    }
+
+    void reset() {
+        std::fill(_counts.begin(), _counts.end(), 0);
+        _max = 0;
+        _samples = 0;
+    }
+
+    /**
+     * Returns the upper bound of the bucket holding the given quantile, so
+     * percentiles are never reported lower than they are.
+     */
+    uint64_t percentile(double q) const {
+        if(!_samples) return 0;
+        size_t rank = std::max<size_t>(1, (size_t)(q * _samples + 0.5));
+        size_t seen = 0;
+        for(size_t i = 0; i < BUCKETS; ++i) {
+            seen += _counts[i];
+            if(seen >= rank) return std::min(highestOf(i), _max);
+        }
+        return _max;
+    }
+
+    uint64_t max() const {
+        return _max;
+    }
+
+    size_t samples() const {
+        return _samples;
+    }
+
+    /**
+     * Calls f(highest value, count) for every bucket with samples.
+     */
+    template<typename F>
+    void forEachBucket(F&& f) const {
+        for(size_t i = 0; i < BUCKETS; ++i) {
+            if(_counts[i]) f(highestOf(i), _counts[i]);
+        }
+    }
+
+    __attribute__((always_inline))
+    static size_t indexOf(uint64_t v) {
+        if(v < SUB_BUCKETS) return v;
+        size_t magnitude = 63 - __builtin_clzll(v);
+        size_t shift = magnitude - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((v >> shift) - SUB_BUCKETS);
+    }
+
+    static uint64_t highestOf(size_t index) {
+        if(index < SUB_BUCKETS) return index;
+        size_t shift = index / SUB_BUCKETS - 1;
+        uint64_t low = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return low + ((1ULL << shift) - 1);
+    }
+
+private:
+    std::vector<uint64_t> _counts;
+    uint64_t _max;
+    size_t _samples;
+};
+
+/**
+ * TSC ticks per nanosecond, measured once against the steady clock.
+ */
+inline double ticksPerNanosecond() {
+    static double ticks = []() {
+        unsigned aux;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t tscStart = __rdtscp(&aux);
+        while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20)) {
+        }
+        uint64_t tscEnd = __rdtscp(&aux);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return (tscEnd - tscStart) / ns;
+    }();
+    return ticks;
+}
+
+/**
+ * Adds the percentiles, in ns, and the histogram to the results.
+ */
+inline void recordLatency(std::string const& prefix, LatencyHistogram const& h) {
+    Results& results = Results::get();
+    double perNs = ticksPerNanosecond();
+    results.set(prefix + ".p50", h.percentile(0.50) / perNs);
+    results.set(prefix + ".p90", h.percentile(0.90) / perNs);
+    results.set(prefix + ".p99", h.percentile(0.99) / perNs);
+    results.set(prefix + ".p99_9", h.percentile(0.999) / perNs);
+    results.set(prefix + ".max", h.max() / perNs);
+    std::stringstream json;
+    json << "[";
+    h.forEachBucket([&json, perNs](uint64_t highest, size_t count) {
+        json << (json.tellp() > 1 ? ", [" : "[") << highest / perNs << ", " << count << "]";
+    });
+    json << "]";
+    results.setJson("hist" + prefix.substr(3), json.str());
+}
+
+template<typename IMPL>
+class ImplLatency {
+public:
+
+    enum Op {
+        INSERT,
+        GET,
+        OPS
+    };
+
+    struct alignas(64) ThreadLatency {
+        LatencyHistogram histogram[OPS];
+        size_t countdown;
+    };
+
+    ImplLatency(IMPL& impl)
+    : _impl(impl)
+    , _sample(std::max<size_t>(1, settingAsUnsigned("latency_sample", 8)))
+    {
+        ticksPerNanosecond();
+    }
+
+    void init(size_t bucketScale) {
+        _threads.clear();
+        _threads.resize(Settings::global()["threads"].asUnsignedValue());
+        _impl.init(bucketScale);
+    }
+
+    void thread_init(int tid) {
+        _tid = tid;
+        _threads[tid].countdown = _sample;
+        _impl.thread_init(tid);
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    void insert(K const& k, V const& v) {
+        ThreadLatency& t = _threads[_tid];
+        if(--t.countdown) {
+            _impl.insert(k, v);
+            return;
+        }
+        t.countdown = _sample;
+        unsigned aux;
+        uint64_t start = __rdtscp(&aux);
+        _impl.insert(k, v);
+        t.histogram[INSERT].record(__rdtscp(&aux) - start);
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    bool get(K const& k, V& v) {
+        ThreadLatency& t = _threads[_tid];
+        if(--t.countdown) {
+            return _impl.get(k, v);
+        }
+        t.countdown = _sample;
+        unsigned aux;
+        uint64_t start = __rdtscp(&aux);
+        bool found = _impl.get(k, v);
+        t.histogram[GET].record(__rdtscp(&aux) - start);
+        return found;
+    }
+
+    void cleanup() {
+        _impl.cleanup();
+    }
+
+    std::string name() const {
+        return _impl.name();
+    }
+
+    void statsString(std::ostream& out, size_t bars) {
+        _impl.statsString(out, bars);
+    }
+
+    /**
+     * Merges the histograms of all threads into the results of the given
+     * phase and starts over for the next one.
+     */
+    void finishPhase(std::string const& phase) {
+        static char const* opNames[OPS] = {"insert", "get"};
+        for(size_t op = 0; op < OPS; ++op) {
+            LatencyHistogram merged;
+            for(auto& t: _threads) {
+                merged.merge(t.histogram[op]);
+                t.histogram[op].reset();
+            }
+            if(merged.samples()) {
+                _phases.emplace_back(phase + " " + opNames[op], std::move(merged));
+            }
+        }
+        endPhase(_impl, phase);
+    }
+
+    /**
+     * Prints a line per phase and operation type that had samples.
+     */
+    void report() {
+        double perNs = ticksPerNanosecond();
+        for(auto& p: _phases) {
+            LatencyHistogram const& h = p.second;
+            printHeader();
+            std::cout << std::fixed << std::setw( 25 ) << p.first
+                      << std::fixed << std::setw( 10 ) << h.samples()
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << h.percentile(0.50) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << h.percentile(0.90) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << h.percentile(0.99) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << h.percentile(0.999) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << h.max() / perNs
+                      << std::endl;
+            recordLatency("lat." + Results::metricName(p.first), h);
+        }
+        _phases.clear();
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "latency (ns)"
+                  << std::fixed << std::setw( 10 ) << "samples"
+                  << std::fixed << std::setw(  9 ) << "p50"
+                  << std::fixed << std::setw(  9 ) << "p90"
+                  << std::fixed << std::setw(  9 ) << "p99"
+                  << std::fixed << std::setw(  9 ) << "p99.9"
+                  << std::fixed << std::setw(  9 ) << "max"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+    IMPL& _impl;
+    size_t _sample;
+    std::vector<ThreadLatency> _threads;
+    std::vector<std::pair<std::string, LatencyHistogram>> _phases;
+    static __thread int _tid;
+};
+
+template<typename IMPL>
+__thread int ImplLatency<IMPL>::_tid;
+
+template<typename IMPL>
+void endPhase(ImplLatency<IMPL>& impl, std::string const& phase) {
+    impl.finishPhase(phase);
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+// Memory footprint per phase, enabled with --memory=1.
+//
+// ImplMemory wraps any Impl* and takes a snapshot of the process before
+// init(), after init() and at the end of every phase (before cleanup() for
+// drivers that clean up within their last phase). For every phase it prints
+//   rss       resident set (/proc/self/statm), and its growth since init()
+//   minflt    minor and major page faults taken in the phase (getrusage)
+//   majflt
+//   thp       anonymous memory backed by transparent huge pages and memory
+//   hugetlb   in hugetlbfs pages (/proc/self/smaps_rollup)
+//   buckets   bytes mapped by init() through MMapper::mmapForMap()
+//   slabres   bytes of SlabManager slabs mapped, and handed out from them
+//   slabused
+//   B/entry   growth of the resident set since init() per insert() call
+// RSS and faults are taken from the kernel, so they also cover the vendor
+// maps, whose allocations do not go through MMapper or a SlabManager. Memory
+// the allocator kept from an earlier table is not counted as growth. With
+// duplicates or with the update operations of --mode=workload, insert() calls
+// overcount the entries that are stored.
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "allocator.h"
+#include "driver.h"
+#include "mmapper.h"
+#include "results.h"
+
+struct MemorySnapshot {
+    size_t rss;
+    size_t minorFaults;
+    size_t majorFaults;
+    size_t thp;
+    size_t hugetlb;
+    size_t buckets;
+    size_t slabs;
+    size_t slabReserved;
+    size_t slabUsed;
+
+    static MemorySnapshot take() {
+        MemorySnapshot m;
+        static size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t pages = 0, resident = 0;
+        std::ifstream statm("/proc/self/statm");
+        statm >> pages >> resident;
+        m.rss = resident * pageSize;
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        m.minorFaults = usage.ru_minflt;
+        m.majorFaults = usage.ru_majflt;
+
+        readSmaps(m.thp, m.hugetlb);
+
+        m.buckets = MMapper::mappedBytes(MMapper::MappingKind::MAP);
+        SlabManager::Usage slabs = SlabManager::totalUsage();
+        m.slabs = slabs.slabs;
+        m.slabReserved = slabs.reserved;
+        m.slabUsed = slabs.used;
+        return m;
+    }
+
+private:
+
+    /**
+     * Sums the huge page lines of smaps_rollup, or of smaps on kernels
+     * without it (before 4.14).
+     */
+    static void readSmaps(size_t& thp, size_t& hugetlb) {
+        thp = hugetlb = 0;
+        std::ifstream smaps("/proc/self/smaps_rollup");
+        if(!smaps) smaps.open("/proc/self/smaps");
+        std::string line;
+        while(std::getline(smaps, line)) {
+            std::stringstream s(line);
+            std::string key;
+            size_t kB = 0;
+            if(!(s >> key >> kB)) continue;
+            if(key == "AnonHugePages:") thp += kB * 1024;
+            else if(key == "Private_Hugetlb:" || key == "Shared_Hugetlb:") hugetlb += kB * 1024;
+        }
+    }
+};
+
+template<typename IMPL>
+class ImplMemory {
+public:
+
+    struct alignas(64) ThreadInserts {
+        size_t inserts = 0;
+    };
+
+    struct PhaseMemory {
+        std::string name;
+        size_t inserts;
+        MemorySnapshot start;
+        MemorySnapshot end;
+    };
+
+    ImplMemory(IMPL& impl)
+    : _impl(impl)
+    {
+    }
+
+    void init(size_t bucketScale) {
+        _threads = std::vector<ThreadInserts>(Settings::global()["threads"].asUnsignedValue());
+        _cleanedUp = false;
+        _beforeInit = MemorySnapshot::take();
+        _impl.init(bucketScale);
+        _afterInit = _phaseStart = MemorySnapshot::take();
+    }
+
+    void thread_init(int tid) {
+        _tid = tid;
+        _impl.thread_init(tid);
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    void insert(K const& k, V const& v) {
+        _threads[_tid].inserts++;
+        _impl.insert(k, v);
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    bool get(K const& k, V& v) {
+        return _impl.get(k, v);
+    }
+
+    /**
+     * SimpleDriver cleans up before its phase ends, so the table is measured
+     * here while it still exists.
+     */
+    void cleanup() {
+        _beforeCleanup = MemorySnapshot::take();
+        _cleanedUp = true;
+        _impl.cleanup();
+    }
+
+    std::string name() const {
+        return _impl.name();
+    }
+
+    void statsString(std::ostream& out, size_t bars) {
+        _impl.statsString(out, bars);
+    }
+
+    void finishPhase(std::string const& phase) {
+        PhaseMemory p;
+        p.name = phase;
+        p.inserts = 0;
+        for(auto& t: _threads) {
+            p.inserts += t.inserts;
+        }
+        p.start = _phaseStart;
+        p.end = _cleanedUp ? _beforeCleanup : MemorySnapshot::take();
+        _phaseStart = p.end;
+        _phases.push_back(p);
+        endPhase(_impl, phase);
+    }
+
+    /**
+     * Prints the footprint at the end of every phase.
+     */
+    void report() {
+        for(auto& p: _phases) {
+            printHeader();
+            MemorySnapshot const& e = p.end;
+            size_t buckets = _afterInit.buckets - _beforeInit.buckets;
+            size_t growth = e.rss > _beforeInit.rss ? e.rss - _beforeInit.rss : 0;
+            std::cout << std::fixed << std::setw( 25 ) << p.name
+                      << std::fixed << std::setw( 12 ) << p.inserts
+                      << std::fixed << std::setw( 10 ) << std::setprecision(1) << mib(e.rss)
+                      << std::fixed << std::setw( 10 ) << std::setprecision(1) << mib(growth)
+                      << std::fixed << std::setw( 10 ) << e.minorFaults - p.start.minorFaults
+                      << std::fixed << std::setw(  8 ) << e.majorFaults - p.start.majorFaults
+                      << std::fixed << std::setw(  9 ) << std::setprecision(1) << mib(e.thp)
+                      << std::fixed << std::setw(  9 ) << std::setprecision(1) << mib(e.hugetlb)
+                      << std::fixed << std::setw( 10 ) << std::setprecision(1) << mib(buckets)
+                      << std::fixed << std::setw( 10 ) << std::setprecision(1) << mib(e.slabReserved)
+                      << std::fixed << std::setw( 10 ) << std::setprecision(1) << mib(e.slabUsed)
+                      ;
+            if(p.inserts) {
+                std::cout << std::fixed << std::setw(  9 ) << std::setprecision(1) << (double)growth / p.inserts;
+            } else {
+                std::cout << std::fixed << std::setw(  9 ) << "-";
+            }
+            std::cout << std::endl;
+
+            Results& results = Results::get();
+            std::string prefix = "mem." + Results::metricName(p.name);
+            results.set(prefix + ".rss", e.rss);
+            results.set(prefix + ".rss_growth", growth);
+            results.set(prefix + ".minflt", e.minorFaults - p.start.minorFaults);
+            results.set(prefix + ".majflt", e.majorFaults - p.start.majorFaults);
+            results.set(prefix + ".thp", e.thp);
+            results.set(prefix + ".hugetlb", e.hugetlb);
+            results.set(prefix + ".buckets", buckets);
+            results.set(prefix + ".slab_reserved", e.slabReserved);
+            results.set(prefix + ".slab_used", e.slabUsed);
+            if(p.inserts) results.set(prefix + ".bytes_per_entry", (double)growth / p.inserts);
+        }
+        _phases.clear();
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "memory (MiB)"
+                  << std::fixed << std::setw( 12 ) << "inserts"
+                  << std::fixed << std::setw( 10 ) << "rss"
+                  << std::fixed << std::setw( 10 ) << "growth"
+                  << std::fixed << std::setw( 10 ) << "minflt"
+                  << std::fixed << std::setw(  8 ) << "majflt"
+                  << std::fixed << std::setw(  9 ) << "thp"
+                  << std::fixed << std::setw(  9 ) << "hugetlb"
+                  << std::fixed << std::setw( 10 ) << "buckets"
+                  << std::fixed << std::setw( 10 ) << "slabres"
+                  << std::fixed << std::setw( 10 ) << "slabused"
+                  << std::fixed << std::setw(  9 ) << "B/entry"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    static double mib(size_t bytes) {
+        return bytes / 1048576.0;
+    }
+
+private:
+    IMPL& _impl;
+    std::vector<ThreadInserts> _threads;
+    std::vector<PhaseMemory> _phases;
+    MemorySnapshot _beforeInit;
+    MemorySnapshot _afterInit;
+    MemorySnapshot _phaseStart;
+    MemorySnapshot _beforeCleanup;
+    bool _cleanedUp = false;
+    static __thread int _tid;
+};
+
+template<typename IMPL>
+__thread int ImplMemory<IMPL>::_tid;
+
+template<typename IMPL>
+void endPhase(ImplMemory<IMPL>& impl, std::string const& phase) {
+    impl.finishPhase(phase);
+}
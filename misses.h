@@ -0,0 +1,154 @@
+#pragma once
+
+// Lookup benchmark with a controlled share of misses, selected with
+// --mode=miss.
+//
+// The table is loaded like in --mode=workload (the first --load fraction of
+// every thread's keys), then every thread issues --operations gets, once for
+// every hit ratio in --hit_ratios=0,0.5,0.9 (default --hit_ratio, 0). A hit
+// looks up a loaded key, a miss one of the keys that were never inserted, so
+// the misses are guaranteed as long as the test has no duplicate keys
+// (--duplicateratio=0, not -T z). The measured hit ratio is printed next to
+// the target, so a table that finds absent keys shows up right away.
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "workload.h"
+
+template<typename TEST, typename IMPL>
+class MissTest: public WorkloadTest<TEST, IMPL> {
+public:
+
+    using Base = WorkloadTest<TEST, IMPL>;
+
+    MissTest(TEST& test, IMPL& impl)
+    : Base(test, impl)
+    {
+    }
+
+    void test() {
+        this->readSettings();
+        if(this->_loaded >= this->_inserts) {
+            this->_loaded = this->_inserts - 1;
+        }
+
+        Timer timer;
+        this->_impl.init(this->_bucketScale);
+        double setupTime = timer.getElapsedSeconds();
+
+        double loadTime = this->load();
+        endPhase(this->_impl, "load");
+
+        for(double hitRatio: hitRatios()) {
+            std::vector<size_t> found(this->_threads * FOUND_STRIDE);
+            double lookupTime = runThreads(this->_threads, [this](size_t tid) { this->_impl.thread_init(tid); }, [this, hitRatio, &found](size_t tid) {
+                found[tid * FOUND_STRIDE] = lookup(tid, hitRatio);
+            });
+            std::string label = "h" + std::to_string((size_t)(hitRatio * 100.0 + 0.5));
+            endPhase(this->_impl, "lookup " + label);
+
+            size_t lookups = this->_operations * this->_threads;
+            size_t hits = 0;
+            for(size_t tid = 0; tid < this->_threads; ++tid) {
+                hits += found[tid * FOUND_STRIDE];
+            }
+
+            printHeader();
+            std::cout << std::fixed << std::setw( 25 ) << this->_impl.name()
+                      << std::fixed << std::setw(  4 ) << this->_bucketScale
+                      << std::fixed << std::setw(  4 ) << this->_threads
+                      << std::fixed << std::setw( 10 ) << this->_loaded * this->_threads
+                      << std::fixed << std::setw( 10 ) << lookups
+                      << std::fixed << std::setw(  7 ) << std::setprecision(3) << setupTime
+                      << std::fixed << std::setw(  7 ) << std::setprecision(3) << loadTime
+                      << std::fixed << std::setw(  8 ) << std::setprecision(3) << lookupTime
+                      << std::fixed << std::setw(  8 ) << std::setprecision(2) << lookups / lookupTime / 1e6
+                      << std::fixed << std::setw(  7 ) << std::setprecision(1) << 100.0 * hitRatio
+                      << std::fixed << std::setw(  7 ) << std::setprecision(1) << 100.0 * hits / lookups
+                      << std::endl;
+
+            Results& results = Results::get();
+            results.set("time.lookup_" + label, lookupTime);
+            results.set("mops.lookup_" + label, lookups / lookupTime / 1e6);
+            results.set("hitratio_" + label, (double)hits / lookups);
+        }
+
+        timer.reset();
+        this->_impl.cleanup();
+
+        Results& results = Results::get();
+        results.set("time.setup", setupTime);
+        results.set("time.load", loadTime);
+        results.set("time.clean", timer.getElapsedSeconds());
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "scl"
+                  << std::fixed << std::setw(  4 ) << "ths"
+                  << std::fixed << std::setw( 10 ) << "loaded"
+                  << std::fixed << std::setw( 10 ) << "lookups"
+                  << std::fixed << std::setw(  7 ) << "setup"
+                  << std::fixed << std::setw(  7 ) << "load"
+                  << std::fixed << std::setw(  8 ) << "lookup"
+                  << std::fixed << std::setw(  8 ) << "Mops"
+                  << std::fixed << std::setw(  7 ) << "hit%"
+                  << std::fixed << std::setw(  7 ) << "found%"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    // Keeps the per-thread hit counters on separate cache lines
+    static constexpr size_t FOUND_STRIDE = 64 / sizeof(size_t);
+
+    static std::vector<double> hitRatios() {
+        std::string list = Settings::global()["hit_ratios"].asString();
+        if(list.empty()) list = Settings::global()["hit_ratio"].asString();
+        std::vector<double> ratios;
+        std::stringstream s(list);
+        std::string ratio;
+        while(std::getline(s, ratio, ',')) {
+            if(!ratio.empty()) ratios.push_back(std::min(1.0, std::max(0.0, std::stod(ratio))));
+        }
+        if(ratios.empty()) ratios.push_back(0.0);
+        return ratios;
+    }
+
+    /**
+     * Issues the gets of thread tid and returns how many of them found their
+     * key. Hits are uniform over the loaded keys of all threads, misses over
+     * the keys that were not loaded.
+     */
+    size_t lookup(size_t tid, double hitRatio) {
+        Random rng(Random::seedFor(this->_seed, tid));
+        typename TEST::value_type v;
+        size_t threads = this->_threads;
+        size_t loaded = this->_loaded;
+        size_t absent = this->_inserts - loaded;
+        size_t found = 0;
+        for(size_t n = 0; n < this->_operations; ++n) {
+            size_t r;
+            size_t i;
+            if(rng.nextDouble() < hitRatio) {
+                r = rng.nextBelow(loaded * threads);
+                i = r / threads;
+            } else {
+                r = rng.nextBelow(absent * threads);
+                i = loaded + r / threads;
+            }
+            found += this->_impl.get(this->_test.key(r % threads, i), v);
+        }
+        return found;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// What get() of the cachechain3 tables does on a miss.
+//
+// FastMisses just returns false. DiagnoseMisses prints "not found?" and walks
+// the chain again with get2(), printing every entry it checks, to debug
+// lookups that should have hit; this makes misses orders of magnitude
+// slower. HashTable uses FastMisses, use BasicHashTable<K, V, DiagnoseMisses>
+// when debugging.
+
+namespace hashtables {
+
+struct FastMisses {
+    static constexpr bool diagnose = false;
+};
+
+struct DiagnoseMisses {
+    static constexpr bool diagnose = true;
+};
+
+}
@@ -11,6 +11,7 @@
 #include "allocator.h"
 #include "mmapper.h"
 #include "murmurhash.h"
+#include "probing.h"
 
 #define CACHE_LINE_SIZE_BP2 6
 #define CACHE_LINE_SIZE_IN_BYTES (1<<CACHE_LINE_SIZE_BP2)
@@ -40,67 +41,101 @@ public:
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask( (_entries-1ULL))
+    , _probeLimit(hashtables::ProbeLimit::fromSettings(_entries))
     {
-        _map = (decltype(_map))MMapper::mmapForMap(_buckets * _bucketSize);
+        _map = (decltype(_map))MMapper::mmapForMap(mapBytes());
     }
 public:
     size_t insert(K const& key, V const& value) {
+        V result;
+        tryInsert(key, value, result);
+        return result;
+    }
+
+    /**
+     * Inserts key unless it is there already. result is the value in the
+     * table afterwards, or value if the table is FULL, see probing.h.
+     */
+    hashtables::InsertResult tryInsert(K const& key, V const& value, V& result) {
 //        printf("key:   %zx\n", key);
         size_t e = entry(key);
 //        printf("entry: %zx\n", e);
-        HashTableEntry<K,V>* current = _map[e].load(std::memory_order_relaxed);
+        size_t slot = e;
+        HashTableEntry<K,V>* current = _map[slot].load(std::memory_order_relaxed);
 //        printf("cur:   %p\n", current);
 
         size_t base = e & (~(_entriesPerBucket-1));
         e -= base;
 
         size_t end = e;
-
-        while(current) {
-            if(current->_key == key) return current->_value;
+        auto sequence = [&]() {
             e = (e+1) & (_entriesPerBucket-1);
             if(e==end) {
                 base += _entriesPerBucket;
                 base &= _entriesMask;
             }
-            current = _map[base+e].load(std::memory_order_relaxed);
+            return base+e;
+        };
+        hashtables::Probe probe(_probeLimit, _entries);
+
+        while(current) {
+            if(current->_key == key) {
+                result = current->_value;
+                return hashtables::InsertResult::FOUND;
+            }
+            if(!probe.next(slot, sequence)) {
+                result = value;
+                return hashtables::InsertResult::FULL;
+            }
+            current = _map[slot].load(std::memory_order_relaxed);
         }
 
         HashTableEntry<K,V>* hte = createHTE(key, value);
-        while(!_map[base+e].compare_exchange_weak(current, hte, std::memory_order_release, std::memory_order_relaxed)) {
+        while(!_map[slot].compare_exchange_weak(current, hte, std::memory_order_release, std::memory_order_relaxed)) {
             while(current) {
-                if(current->_key == key) return current->_value;
-                e = (e+1) & (_entriesPerBucket-1);
-                if(e==end) {
-                    base += _entriesPerBucket;
-                    base &= _entriesMask;
+                if(current->_key == key) {
+                    result = current->_value;
+                    return hashtables::InsertResult::FOUND;
                 }
-                current = _map[base+e].load(std::memory_order_relaxed);
+                if(!probe.next(slot, sequence)) {
+                    // Nothing was allocated after hte, so it can go back
+                    _slabManager.free(hte);
+                    result = value;
+                    return hashtables::InsertResult::FULL;
+                }
+                current = _map[slot].load(std::memory_order_relaxed);
             }
         }
-        return value;
+        result = value;
+        return hashtables::InsertResult::INSERTED;
     }
 
     bool get(K const& key, V& value) {
 
         size_t e = entry(key);
-        HashTableEntry<K,V>* current = _map[e].load(std::memory_order_relaxed);
+        size_t slot = e;
+        HashTableEntry<K,V>* current = _map[slot].load(std::memory_order_relaxed);
 
         size_t base = e & (~(_entriesPerBucket-1));
         e -= base;
         size_t end = e;
+        auto sequence = [&]() {
+            e = (e+1) & (_entriesPerBucket-1);
+            if(e==end) {
+                base += _entriesPerBucket;
+                base &= _entriesMask;
+            }
+            return base+e;
+        };
+        hashtables::Probe probe(_probeLimit, _entries);
 
         while(current) {
             if(current->_key == key) {
                 value = current->_value;
                 return true;
             }
-            e = (e+1) & (_entriesPerBucket-1);
-            if(e==end) {
-                base += _entriesPerBucket;
-                base &= _entriesMask;
-            }
-            current = _map[base+e].load(std::memory_order_relaxed);
+            if(!probe.next(slot, sequence)) break;
+            current = _map[slot].load(std::memory_order_relaxed);
         }
         return false;
     }
@@ -148,7 +183,11 @@ public:
     }
 
     ~HashTable() {
-        munmap(_map, _buckets * _bucketSize);
+        munmap(_map, mapBytes());
+    }
+
+    size_t mapBytes() const {
+        return _buckets * _bucketSize + _probeLimit.stashSlots * sizeof(std::atomic<HashTableEntry<K,V>*>);
     }
 
     template<typename CONTAINER>
@@ -223,6 +262,7 @@ private:
     size_t const _bucketsMask;
     size_t const _entries;
     size_t const _entriesMask;
+    hashtables::ProbeLimit const _probeLimit;
     std::atomic<HashTableEntry<K,V>*>* _map;
     SlabManager _slabManager;
 
@@ -1,28 +1,121 @@
 #pragma once
 
 #include <sys/mman.h>
+#include <unistd.h>
+#include <numa.h>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 #include <libfrugi/Settings.h>
 
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
 using namespace libfrugi;
 
+/*
+ * Page modes, selected with --page_mode=...:
+ *   auto    - hugetlbfs 1GiB, then hugetlbfs 2MiB, then THP, then normal pages (default)
+ *   hugetlb - hugetlbfs pages of 2^page_size_scale bytes (-p), rounded down to
+ *             a supported size, then THP, then normal pages
+ *   thp     - normal mapping with madvise(MADV_HUGEPAGE)
+ *   normal  - normal pages, no hint
+ * Hugetlbfs mappings are made without MAP_NORESERVE so an exhausted pool makes
+ * mmap() fail and we fall back, instead of a SIGBUS on first touch.
+ *
+ * Bucket arrays are faulted lazily unless one of these is set:
+ *   --populate=1       - populate the whole mapping in mmap()
+ *   --prefault=<n>     - touch the mapping with n threads, see prefault()
+ */
 class MMapper {
 public:
-    static void* mmap(size_t bytesNeeded, size_t pageSizePower) {
-        size_t page_size = 1ULL << pageSizePower;
-        size_t numberOfPages = bytesNeeded / page_size;
-        if(numberOfPages > 1ULL) {
-        } else {
-            numberOfPages = 1ULL;
+
+    enum class PageMode {
+        AUTO,
+        HUGETLB,
+        THP,
+        NORMAL,
+    };
+
+    enum class MappingKind {
+        MAP,
+        SLAB,
+        MAPPING_KINDS,
+    };
+
+    struct Mapping {
+        void* addr;
+        size_t pageSizePower;   // 0 for normal and THP pages
+        bool thp;
+    };
+
+    static PageMode pageModeFromString(std::string const& s) {
+        if(s == "hugetlb") return PageMode::HUGETLB;
+        if(s == "thp") return PageMode::THP;
+        if(s == "normal") return PageMode::NORMAL;
+        return PageMode::AUTO;
+    }
+
+    static Mapping mmap(size_t bytesNeeded, PageMode mode, size_t pageSizePower, bool populate = false) {
+        Mapping m{MAP_FAILED, 0, false};
+        if(mode == PageMode::AUTO || mode == PageMode::HUGETLB) {
+            if(mode == PageMode::AUTO) pageSizePower = 30;
+            for(size_t power: {30ULL, 21ULL}) {
+                // Only use page sizes that divide the mapping, so a plain munmap() of the same length works
+                if(power > pageSizePower || bytesNeeded < (1ULL << power) || (bytesNeeded & ((1ULL << power) - 1))) continue;
+                m.addr = mmapHugeTLB(bytesNeeded, power, populate);
+                if(m.addr != MAP_FAILED) {
+                    m.pageSizePower = power;
+                    return m;
+                }
+            }
         }
-        size_t map_page_size = pageSizePower << MAP_HUGE_SHIFT;
-        auto map = ::mmap(nullptr, bytesNeeded, PROT_READ|PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | map_page_size, -1, 0);
-        return map;
+        m.addr = ::mmap(nullptr, bytesNeeded, PROT_READ|PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(m.addr != MAP_FAILED && mode != PageMode::NORMAL) {
+            m.thp = !madvise(m.addr, bytesNeeded, MADV_HUGEPAGE);
+        }
+
+        // Populate after the THP hint, otherwise MAP_POPULATE would fault in small pages
+        if(m.addr != MAP_FAILED && populate) {
+#ifdef MADV_POPULATE_WRITE
+            if(madvise(m.addr, bytesNeeded, MADV_POPULATE_WRITE))
+#endif
+            prefault(m.addr, bytesNeeded, 1);
+        }
+        return m;
+    }
+
+    static void* mmap(size_t bytesNeeded, size_t pageSizePower) {
+        return mmap(bytesNeeded, pageMode(), pageSizePower).addr;
     }
 
     static void* mmapForMap(size_t bytesNeeded) {
-        auto map = MMapper::mmap(bytesNeeded, Settings::global()["page_size_scale"].asUnsignedValue());
-        posix_madvise(map, bytesNeeded, POSIX_MADV_RANDOM);
-        return map;
+        Settings& settings = Settings::global();
+        auto m = MMapper::mmap(bytesNeeded, pageMode(), settings["page_size_scale"].asUnsignedValue(), settings["populate"].asUnsignedValue());
+        report(MappingKind::MAP, m);
+        account(MappingKind::MAP, m, bytesNeeded);
+        posix_madvise(m.addr, bytesNeeded, POSIX_MADV_RANDOM);
+        if(m.addr != MAP_FAILED) {
+            prefault(m.addr, bytesNeeded, settings["prefault"].asUnsignedValue());
+        }
+        return m.addr;
+    }
+
+    static void* mmapForSlab(size_t bytesNeeded) {
+        return mmapForSlab(bytesNeeded, pageMode(), Settings::global()["page_size_scale"].asUnsignedValue());
+    }
+
+    static void* mmapForSlab(size_t bytesNeeded, PageMode mode, size_t pageSizePower) {
+        auto m = MMapper::mmap(bytesNeeded, mode, pageSizePower);
+        report(MappingKind::SLAB, m);
+        account(MappingKind::SLAB, m, bytesNeeded);
+        return m.addr;
     }
 
     static void* mmapForBucket() {
@@ -35,4 +128,106 @@ public:
     static void munmap(void* addr, size_t len) {
         ::munmap(addr, len);
     }
+
+    /**
+     * Zeroes a mapping. MADV_DONTNEED drops the pages, so they are zero-filled
+     * lazily on their next touch. If the kernel refuses (older kernels do for
+     * hugetlbfs), the range is cleared by hand.
+     */
+    static void wipe(void* addr, size_t bytes) {
+        if(madvise(addr, bytes, MADV_DONTNEED)) {
+            memset(addr, 0, bytes);
+        }
+    }
+
+    /**
+     * Touches every page of [addr, addr+bytes) using the given number of
+     * threads, so the faults are taken here instead of in the first inserts.
+     * Thread t touches the t-th contiguous chunk after moving itself to NUMA
+     * node t*nodes/threads, so first-touch places the chunks node by node.
+     * The touch is an atomic or with 0, so it does not disturb live data.
+     */
+    static void prefault(void* addr, size_t bytes, size_t threads) {
+        if(threads == 0 || bytes == 0) return;
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t pages = (bytes + pageSize - 1) / pageSize;
+        threads = std::min(threads, pages);
+        int nodes = numa_available() < 0 ? 1 : numa_num_configured_nodes();
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for(size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([=]() {
+                if(nodes > 1) {
+                    numa_run_on_node(t * nodes / threads);
+                }
+                char* p = (char*)addr + (pages * t / threads) * pageSize;
+                char* end = (char*)addr + std::min(bytes, (pages * (t+1) / threads) * pageSize);
+                for(; p < end; p += pageSize) {
+                    __atomic_fetch_or(p, 0, __ATOMIC_RELAXED);
+                }
+            });
+        }
+        for(auto& w: workers) {
+            w.join();
+        }
+    }
+
+    static PageMode pageMode() {
+        return pageModeFromString(Settings::global()["page_mode"].asString());
+    }
+
+    static std::string describe(Mapping const& m) {
+        if(m.addr == MAP_FAILED) return "mmap failed";
+        if(m.pageSizePower >= 30) return std::to_string(1ULL << (m.pageSizePower - 30)) + "GiB hugetlb pages";
+        if(m.pageSizePower) return std::to_string(1ULL << (m.pageSizePower - 20)) + "MiB hugetlb pages";
+        if(m.thp) return "THP (madvised, system policy: " + thpPolicy() + ")";
+        return "4KiB pages";
+    }
+
+    /**
+     * Prints the page size obtained the first time a bucket array or slab is
+     * mapped, and again whenever a later mapping of that kind falls back to
+     * something else.
+     */
+    static void report(MappingKind kind, Mapping const& m) {
+        static std::atomic<int> lastReported[(int)MappingKind::MAPPING_KINDS] = {};
+        int code = m.addr == MAP_FAILED ? -1 : (int)(m.pageSizePower << 1 | m.thp) + 1;
+        if(lastReported[(int)kind].exchange(code, std::memory_order_relaxed) == code) return;
+        std::cerr << "MMapper: " << (kind == MappingKind::MAP ? "bucket array" : "slab")
+                  << " mapped using " << describe(m) << std::endl;
+    }
+
+    /**
+     * Bytes mapped so far for bucket arrays or slabs. Only ever grows, the
+     * mappings are unmapped by their owners; take the difference of two reads
+     * to get the size of what was mapped in between.
+     */
+    static size_t mappedBytes(MappingKind kind) {
+        return mapped()[(int)kind].load(std::memory_order_relaxed);
+    }
+
+    static std::string thpPolicy() {
+        std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string line;
+        std::getline(f, line);
+        auto b = line.find('[');
+        auto e = line.find(']');
+        if(b == std::string::npos || e == std::string::npos) return "unknown";
+        return line.substr(b + 1, e - b - 1);
+    }
+
+private:
+
+    static std::atomic<size_t>* mapped() {
+        static std::atomic<size_t> bytes[(int)MappingKind::MAPPING_KINDS] = {};
+        return bytes;
+    }
+
+    static void account(MappingKind kind, Mapping const& m, size_t bytes) {
+        if(m.addr != MAP_FAILED) mapped()[(int)kind].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static void* mmapHugeTLB(size_t bytesNeeded, size_t pageSizePower, bool populate) {
+        return ::mmap(nullptr, bytesNeeded, PROT_READ|PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (pageSizePower << MAP_HUGE_SHIFT) | (populate ? MAP_POPULATE : 0), -1, 0);
+    }
 };
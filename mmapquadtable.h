@@ -9,6 +9,8 @@
 #include <new>
 
 #include "allocator.h"
+#include "casstats.h"
+#include "generation.h"
 #include "mmapper.h"
 #include "murmurhash.h"
 
@@ -29,12 +31,12 @@ public:
     V _value;
 };
 
-template<typename K, typename V>
-class HashTable {
+template<typename K, typename V, typename TAGS = hashtables::Untagged>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_entriesPerBucket)
     , _bucketsMask((_buckets-1ULL))
@@ -44,6 +46,21 @@ public:
         _map = (decltype(_map))MMapper::mmapForMap(_buckets * _bucketSize);
     }
 public:
+
+    template<typename T>
+    static T* getPtr(T* ptr) {
+        return (T*)((intptr_t)ptr & 0x0000FFFFFFFFFFFFULL);
+    }
+
+    /**
+     * Slots hold a 48 bit pointer, with TAGS = GenerationTagged behind 8 bits
+     * generation, see generation.h.
+     */
+    template<typename T>
+    bool isLive(T* ptr) const {
+        return _tags.isLive(ptr);
+    }
+
     size_t insert(K const& key, V const& value) {
 //        printf("key:   %zx\n", key);
         size_t e = entry(key);
@@ -53,19 +70,20 @@ public:
 
         size_t increment = 0;
 
-        while(current) {
+        while(isLive(current)) {
 //            printf("checking existing entry: %zx -> %zx\n", current->_key, current->_value);
-            if(current->_key == key) return current->_value;
+            if(getPtr(current)->_key == key) return getPtr(current)->_value;
             e = (e+1+increment*2) & _entriesMask;
             increment++;
             current = _map[e].load(std::memory_order_relaxed);
         }
 
-        HashTableEntry<K,V>* hte = createHTE(key, value);
-        while(!_map[e].compare_exchange_weak(current, hte, std::memory_order_release, std::memory_order_relaxed)) {
-            while(current) {
+        HashTableEntry<K,V>* hte = (HashTableEntry<K,V>*)((intptr_t)createHTE(key, value) | _tags.tag());
+        CasStats::Op cas;
+        while(!cas.weak(_map[e], current, hte, std::memory_order_release, std::memory_order_relaxed)) {
+            while(isLive(current)) {
 //                printf("checking existing entry: %zx -> %zx\n", current->_key, current->_value);
-                if(current->_key == key) return current->_value;
+                if(getPtr(current)->_key == key) return getPtr(current)->_value;
                 e = (e+1+increment*2) & _entriesMask;
                 increment++;
                 current = _map[e].load(std::memory_order_relaxed);
@@ -82,10 +100,10 @@ public:
 
         size_t increment = 0;
 
-        while(current) {
+        while(isLive(current)) {
 //            printf("checking existing entry: %zx -> %zx\n", current->_key, current->_value);
-            if(current->_key == key) {
-                value = current->_value;
+            if(getPtr(current)->_key == key) {
+                value = getPtr(current)->_value;
                 return true;
             }
             e = (e+1+increment*2) & _entriesMask;
@@ -130,6 +148,16 @@ public:
         printf("size = %zu\n", size());
     }
 
+    /**
+     * Empties the table, in O(1) if it is GenerationTagged, see
+     * generation.h, and rewinds the slabs. Must not run concurrently with
+     * other operations on the table.
+     */
+    void clear() {
+        _tags.clear(_map, _buckets * _bucketSize);
+        _slabManager.reset();
+    }
+
     void thread_init() {
         _slabManager.thread_init();
     }
@@ -138,7 +166,7 @@ public:
         return new(_slabManager.alloc<HashTableEntry<K,V>>()) HashTableEntry<K,V>(key, value);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -156,7 +184,7 @@ public:
                 size_t bucketSize = 0;
 
                 for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                    if(_map[idx+b].load(std::memory_order_relaxed)) {
+                    if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                         bucketSize++;
                     }
                 }
@@ -189,7 +217,7 @@ public:
             size_t bucketSize = 0;
 
             for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                if(_map[idx+b].load(std::memory_order_relaxed)) {
+                if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                     bucketSize++;
                 }
             }
@@ -215,6 +243,7 @@ private:
     size_t const _entries;
     size_t const _entriesMask;
     std::atomic<HashTableEntry<K,V>*>* _map;
+    TAGS _tags;
     SlabManager _slabManager;
 
 private:
@@ -222,4 +251,10 @@ private:
     static size_t constexpr _entriesPerBucket = _bucketSize/sizeof(void*);
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::Untagged>;
+
+template<typename K, typename V>
+using GenerationTaggedHashTable = BasicHashTable<K, V, hashtables::GenerationTagged>;
+
 }
@@ -9,6 +9,8 @@
 #include <new>
 
 #include "allocator.h"
+#include "casstats.h"
+#include "generation.h"
 #include "mmapper.h"
 #include "murmurhash.h"
 
@@ -29,21 +31,37 @@ public:
     V _value;
 };
 
-template<typename K, typename V>
-class HashTable {
+template<typename K, typename V, typename TAGS = hashtables::Untagged>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_entriesPerBucket)
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask( (_entries-1ULL))
+    , _slabManager(SlabPolicy::forScale(bucketsScale))
     {
         _map = (decltype(_map))MMapper::mmapForMap(_buckets * _bucketSize);
     }
 public:
+
+    template<typename T>
+    static T* getPtr(T* ptr) {
+        return (T*)((intptr_t)ptr & 0x0000FFFFFFFFFFFFULL);
+    }
+
+    /**
+     * Slots hold a 48 bit pointer, with TAGS = GenerationTagged behind 8 bits
+     * generation, see generation.h.
+     */
+    template<typename T>
+    bool isLive(T* ptr) const {
+        return _tags.isLive(ptr);
+    }
+
     size_t insert(K const& key, V const& value) {
 
         size_t e = entry(key);
@@ -55,8 +73,8 @@ public:
         size_t end = e;
         size_t increment = 0;
 
-        while(current) {
-            if(current->_key == key) return current->_value;
+        while(isLive(current)) {
+            if(getPtr(current)->_key == key) return getPtr(current)->_value;
             e = (e+1) & (_entriesPerBucket-1);
             if(e==end) {
                 base += _entriesPerBucket * (1 + increment * 2);
@@ -66,10 +84,11 @@ public:
             current = _map[base+e].load(std::memory_order_relaxed);
         }
 
-        HashTableEntry<K,V>* hte = createHTE(key, value);
-        while(!_map[base+e].compare_exchange_weak(current, hte, std::memory_order_release, std::memory_order_relaxed)) {
-            while(current) {
-                if(current->_key == key) return current->_value;
+        HashTableEntry<K,V>* hte = (HashTableEntry<K,V>*)((intptr_t)createHTE(key, value) | _tags.tag());
+        CasStats::Op cas;
+        while(!cas.weak(_map[base+e], current, hte, std::memory_order_release, std::memory_order_relaxed)) {
+            while(isLive(current)) {
+                if(getPtr(current)->_key == key) return getPtr(current)->_value;
                 e = (e+1) & (_entriesPerBucket-1);
                 if(e==end) {
                     base += _entriesPerBucket * (1 + increment * 2);
@@ -92,9 +111,9 @@ public:
         size_t end = e;
         size_t increment = 0;
 
-        while(current) {
-            if(current->_key == key) {
-                value = current->_value;
+        while(isLive(current)) {
+            if(getPtr(current)->_key == key) {
+                value = getPtr(current)->_value;
                 return true;
             }
             e = (e+1) & (_entriesPerBucket-1);
@@ -142,6 +161,16 @@ public:
         printf("size = %zu\n", size());
     }
 
+    /**
+     * Empties the table, in O(1) if it is GenerationTagged, see
+     * generation.h, and rewinds the slabs. Must not run concurrently with
+     * other operations on the table.
+     */
+    void clear() {
+        _tags.clear(_map, _buckets * _bucketSize);
+        _slabManager.reset();
+    }
+
     void thread_init() {
         _slabManager.thread_init();
     }
@@ -150,7 +179,7 @@ public:
         return new(_slabManager.alloc<HashTableEntry<K,V>>()) HashTableEntry<K,V>(key, value);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -168,7 +197,7 @@ public:
                 size_t bucketSize = 0;
 
                 for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                    if(_map[idx+b].load(std::memory_order_relaxed)) {
+                    if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                         bucketSize++;
                     }
                 }
@@ -201,7 +230,7 @@ public:
             size_t bucketSize = 0;
 
             for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                if(_map[idx+b].load(std::memory_order_relaxed)) {
+                if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                     bucketSize++;
                 }
             }
@@ -227,6 +256,7 @@ private:
     size_t const _entries;
     size_t const _entriesMask;
     std::atomic<HashTableEntry<K,V>*>* _map;
+    TAGS _tags;
     SlabManager _slabManager;
 
 private:
@@ -234,4 +264,10 @@ private:
     static size_t constexpr _entriesPerBucket = _bucketSize/sizeof(void*);
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::Untagged>;
+
+template<typename K, typename V>
+using GenerationTaggedHashTable = BasicHashTable<K, V, hashtables::GenerationTagged>;
+
 }
@@ -9,6 +9,8 @@
 #include <new>
 
 #include "allocator.h"
+#include "casstats.h"
+#include "generation.h"
 #include "mmapper.h"
 #include "murmurhash.h"
 
@@ -29,12 +31,12 @@ public:
     V _value;
 };
 
-template<typename K, typename V>
-class HashTable {
+template<typename K, typename V, typename TAGS = hashtables::Untagged>
+class BasicHashTable {
 public:
     static constexpr size_t PAGE_SIZE_P2 = 20;
 public:
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_entriesPerBucket)
     , _bucketsMask((_buckets-1ULL))
@@ -47,7 +49,17 @@ public:
 
     template<typename T>
     static size_t getHash(T* ptr) {
-        return ((intptr_t)ptr & 0xFFFF000000000000ULL);
+        return ((intptr_t)ptr & TAGS::HASH_MASK);
+    }
+
+    /**
+     * Slots hold 16 bits hash and a 48 bit pointer, with TAGS =
+     * GenerationTagged 8 bits generation, 8 bits hash and the pointer, see
+     * generation.h.
+     */
+    template<typename T>
+    bool isLive(T* ptr) const {
+        return _tags.isLive(ptr);
     }
 
     template<typename T>
@@ -73,7 +85,7 @@ public:
         size_t end = e;
         size_t increment = 0;
 
-        while(current) {
+        while(isLive(current)) {
             size_t currentHash = getHash(current);
             current = getPtr(current);
             if(currentHash == h16l) {
@@ -89,9 +101,10 @@ public:
         }
 
         HashTableEntry<K,V>* hte = createHTE(key, value);
-        HashTableEntry<K,V>* hteWithHash = makePtrWithHash(hte, h16l);
-        while(!_map[base+e].compare_exchange_weak(current, hteWithHash, std::memory_order_release, std::memory_order_relaxed)) {
-            while(current) {
+        HashTableEntry<K,V>* hteWithHash = makePtrWithHash(hte, h16l | _tags.tag());
+        CasStats::Op cas;
+        while(!cas.weak(_map[base+e], current, hteWithHash, std::memory_order_release, std::memory_order_relaxed)) {
+            while(isLive(current)) {
                 size_t currentHash = getHash(current);
                 current = getPtr(current);
                 if(currentHash == h16l) {
@@ -121,7 +134,7 @@ public:
         size_t end = e;
         size_t increment = 0;
 
-        while(current) {
+        while(isLive(current)) {
             size_t currentHash = getHash(current);
             current = getPtr(current);
             if(currentHash == h16l) {
@@ -144,7 +157,7 @@ public:
     size_t hash16LeftFromHash(size_t h) const {
 //        h ^= h << 32ULL;
 //        h ^= h << 16ULL;
-        return h & 0xFFFF000000000000ULL;
+        return h & TAGS::HASH_MASK;
     }
 
     size_t entryFromhash(size_t const& h) {
@@ -181,6 +194,16 @@ public:
         printf("size = %zu\n", size());
     }
 
+    /**
+     * Empties the table, in O(1) if it is GenerationTagged, see
+     * generation.h, and rewinds the slabs. Must not run concurrently with
+     * other operations on the table.
+     */
+    void clear() {
+        _tags.clear(_map, _buckets * _bucketSize);
+        _slabManager.reset();
+    }
+
     void thread_init() {
         _slabManager.thread_init();
     }
@@ -189,7 +212,7 @@ public:
         return new(_slabManager.alloc<HashTableEntry<K,V>>()) HashTableEntry<K,V>(key, value);
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -207,7 +230,7 @@ public:
                 size_t bucketSize = 0;
 
                 for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                    if(_map[idx+b].load(std::memory_order_relaxed)) {
+                    if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                         bucketSize++;
                     }
                 }
@@ -240,7 +263,7 @@ public:
             size_t bucketSize = 0;
 
             for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                if(_map[idx+b].load(std::memory_order_relaxed)) {
+                if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                     bucketSize++;
                 }
             }
@@ -266,6 +289,7 @@ private:
     size_t const _entries;
     size_t const _entriesMask;
     std::atomic<HashTableEntry<K,V>*>* _map;
+    TAGS _tags;
     SlabManager _slabManager;
 
 private:
@@ -273,4 +297,10 @@ private:
     static size_t constexpr _entriesPerBucket = _bucketSize/sizeof(void*);
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::Untagged>;
+
+template<typename K, typename V>
+using GenerationTaggedHashTable = BasicHashTable<K, V, hashtables::GenerationTagged>;
+
 }
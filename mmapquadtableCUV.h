@@ -9,58 +9,77 @@
 #include <new>
 
 #include "allocator.h"
+#include "casstats.h"
+#include "generation.h"
 #include "mmapper.h"
 #include "murmurhash.h"
+#include "probing.h"
 #include "key_accessor.h"
+#include "key_storage.h"
 
 #define CACHE_LINE_SIZE_BP2 6
 #define CACHE_LINE_SIZE_IN_BYTES (1<<CACHE_LINE_SIZE_BP2)
 
 namespace mmapquadtableCUV {
 
-template<typename K, typename V>
+template<typename K, typename V, typename KEYS = hashtables::CopiedKeys>
 class HashTableEntry {
 public:
 
-    HashTableEntry(size_t length, const char* keyData, V const& value): _value(value), _length(length) {
-        memmove(_keyData, keyData, length);
+    HashTableEntry(size_t length, const char* keyData, V const& value): _value(value), _key(length, keyData) {
     }
 
     size_t size() const {
-        return sizeof(HashTableEntry) + _length;
+        return sizeof(HashTableEntry) + hashtables::KeyStorage<KEYS>::extraBytes(_key.length());
     }
 
     bool matches(size_t length, const char* keyData) const {
-        if( _length != length) return false;
-        return !memcmp(_keyData, keyData, length);
+        return _key.matches(length, keyData);
     }
 
 public:
     V _value;
-    size_t _length;
-    char _keyData[0];
+    hashtables::KeyStorage<KEYS> _key;
 };
 
-template<typename K, typename V>
-class HashTable {
+/**
+ * KEYS selects whether entries hold a copy of the key bytes (CopiedKeys) or
+ * refer to the bytes of the inserted key (ExternalKeys), see key_storage.h.
+ * TAGS selects whether slots carry a generation for an O(1) clear(), see
+ * generation.h.
+ */
+template<typename K, typename V, typename KEYS = hashtables::CopiedKeys, typename TAGS = hashtables::Untagged>
+class BasicHashTable {
 public:
 
-    using HTE = HashTableEntry<K,V>;
+    using HTE = HashTableEntry<K,V,KEYS>;
 
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_entriesPerBucket)
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask( (_entries-1ULL))
+    , _probeLimit(hashtables::ProbeLimit::fromSettings(_entries))
+    , _slabManager(SlabPolicy::forScale(bucketsScale))
     {
-        _map = (decltype(_map))MMapper::mmapForMap(_buckets * _bucketSize);
+        _map = (decltype(_map))MMapper::mmapForMap(mapBytes());
     }
 public:
 
     template<typename T>
     static size_t getHash(T* ptr) {
-        return ((intptr_t)ptr & 0xFFFF000000000000ULL);
+        return ((intptr_t)ptr & TAGS::HASH_MASK);
+    }
+
+    /**
+     * Slots hold 16 bits hash and a 48 bit pointer, with TAGS =
+     * GenerationTagged 8 bits generation, 8 bits hash and the pointer, see
+     * generation.h.
+     */
+    template<typename T>
+    bool isLive(T* ptr) const {
+        return _tags.isLive(ptr);
     }
 
     template<typename T>
@@ -74,75 +93,110 @@ public:
     }
 
     size_t insert(K const& key, V const& value) {
+        V result;
+        tryInsert(key, value, result);
+        return result;
+    }
+
+    /**
+     * Inserts key unless it is there already. result is the value in the
+     * table afterwards, or value if the table is FULL, see probing.h.
+     */
+    hashtables::InsertResult tryInsert(K const& key, V const& value, V& result) {
 
         size_t h = hash(key);
         size_t h16l = hash16LeftFromHash(h);
         size_t e = entryFromhash(h);
-        HashTableEntry<K,V>* current = _map[e].load(std::memory_order_relaxed);
+        size_t slot = e;
+        HashTableEntry<K,V,KEYS>* current = _map[slot].load(std::memory_order_relaxed);
 
         size_t base = e & (~(_entriesPerBucket-1));
         e -= base;
 
         size_t end = e;
         size_t increment = 0;
+        auto sequence = [&]() {
+            e = (e+1) & (_entriesPerBucket-1);
+            if(e==end) {
+                base += _entriesPerBucket * (1 + increment * 2);
+                base &= _entriesMask;
+                increment++;
+            }
+            return base+e;
+        };
+        hashtables::Probe probe(_probeLimit, _entries);
 
         size_t length = hashtables::key_accessor<K>::size(key);
 
-        while(current) {
+        while(isLive(current)) {
             size_t currentHash = getHash(current);
             current = getPtr(current);
             if(currentHash == h16l) {
                 if(current->matches(length, hashtables::key_accessor<K>::data(key))) {
-                    return current->_value;
+                    result = current->_value;
+                    return hashtables::InsertResult::FOUND;
                 }
             }
-            e = (e+1) & (_entriesPerBucket-1);
-            if(e==end) {
-                base += _entriesPerBucket * (1 + increment * 2);
-                base &= _entriesMask;
-                increment++;
+            if(!probe.next(slot, sequence)) {
+                result = value;
+                return hashtables::InsertResult::FULL;
             }
-            current = _map[base+e].load(std::memory_order_relaxed);
+            current = _map[slot].load(std::memory_order_relaxed);
         }
 
-        HashTableEntry<K,V>* hte = createHTE(length, hashtables::key_accessor<K>::data(key), value);
-        HashTableEntry<K,V>* hteWithHash = makePtrWithHash(hte, h16l);
-        while(!_map[base+e].compare_exchange_weak(current, hteWithHash, std::memory_order_release, std::memory_order_relaxed)) {
-            while(current) {
+        size_t hteBytes = sizeof(HTE) + hashtables::KeyStorage<KEYS>::extraBytes(length);
+        HashTableEntry<K,V,KEYS>* hte = createHTE(length, hashtables::key_accessor<K>::data(key), value);
+        HashTableEntry<K,V,KEYS>* hteWithHash = makePtrWithHash(hte, h16l | _tags.tag());
+        CasStats::Op cas;
+        while(!cas.weak(_map[slot], current, hteWithHash, std::memory_order_release, std::memory_order_relaxed)) {
+            while(isLive(current)) {
                 size_t currentHash = getHash(current);
                 current = getPtr(current);
                 if(currentHash == h16l) {
                     if(current->matches(length, hashtables::key_accessor<K>::data(key))) {
-                        return current->_value;
+                        result = current->_value;
+                        return hashtables::InsertResult::FOUND;
                     }
                 }
-                e = (e+1) & (_entriesPerBucket-1);
-                if(e==end) {
-                    base += _entriesPerBucket * (1 + increment * 2);
-                    base &= _entriesMask;
-                    increment++;
+                if(!probe.next(slot, sequence)) {
+                    // Nothing was allocated after hte, so it can go back
+                    _slabManager.free(hte, hteBytes);
+                    result = value;
+                    return hashtables::InsertResult::FULL;
                 }
-                current = _map[base+e].load(std::memory_order_relaxed);
+                current = _map[slot].load(std::memory_order_relaxed);
             }
         }
-        return value;
+        result = value;
+        return hashtables::InsertResult::INSERTED;
     }
 
     bool get(K const& key, V& value) {
         size_t h = hash(key);
         size_t h16l = hash16LeftFromHash(h);
         size_t e = entryFromhash(h);
-        HashTableEntry<K,V>* current = _map[e].load(std::memory_order_relaxed);
+        size_t slot = e;
+        HashTableEntry<K,V,KEYS>* current = _map[slot].load(std::memory_order_relaxed);
 
         size_t base = e & (~(_entriesPerBucket-1));
         e -= base;
 
         size_t end = e;
         size_t increment = 0;
+        auto sequence = [&]() {
+            e = (e+1) & (_entriesPerBucket-1);
+            if(e==end) {
+                base += _entriesPerBucket * (1 + increment * 2);
+                base &= _entriesMask;
+                increment++;
+            }
+            return base+e;
+        };
+        hashtables::Probe probe(_probeLimit, _entries);
 
         size_t length = hashtables::key_accessor<K>::size(key);
 
-        while(current) {
+        while(isLive(current)) {
             size_t currentHash = getHash(current);
             current = getPtr(current);
             if(currentHash == h16l) {
@@ -151,13 +205,8 @@ public:
                     return true;
                 }
             }
-            e = (e+1) & (_entriesPerBucket-1);
-            if(e==end) {
-                base += _entriesPerBucket * (1 + increment * 2);
-                base &= _entriesMask;
-                increment++;
-            }
-            current = _map[base+e].load(std::memory_order_relaxed);
+            if(!probe.next(slot, sequence)) break;
+            current = _map[slot].load(std::memory_order_relaxed);
         }
         return false;
     }
@@ -165,7 +214,7 @@ public:
     size_t hash16LeftFromHash(size_t h) const {
 //        h ^= h << 32ULL;
 //        h ^= h << 16ULL;
-        return h & 0xFFFF000000000000ULL;
+        return h & TAGS::HASH_MASK;
     }
 
     size_t entryFromhash(size_t const& h) {
@@ -176,9 +225,9 @@ public:
         return MurmurHash64(key);
     }
 
-    size_t bucketSize(std::atomic<HashTableEntry<K,V>*>* bucket) {
+    size_t bucketSize(std::atomic<HashTableEntry<K,V,KEYS>*>* bucket) {
         size_t s = 0;
-        HashTableEntry<K,V>* current = bucket->load(std::memory_order_relaxed);
+        HashTableEntry<K,V,KEYS>* current = bucket->load(std::memory_order_relaxed);
         while(current) {
             s++;
             current = current->getNext();
@@ -188,8 +237,8 @@ public:
 
     size_t size() {
         size_t s = 0;
-        std::atomic<HashTableEntry<K,V>*>* bucket = _map;
-        std::atomic<HashTableEntry<K,V>*>* end = _map + _buckets;
+        std::atomic<HashTableEntry<K,V,KEYS>*>* bucket = _map;
+        std::atomic<HashTableEntry<K,V,KEYS>*>* end = _map + _buckets;
         while(bucket < end) {
             s += bucketSize(bucket);
             bucket++;
@@ -202,18 +251,32 @@ public:
         printf("size = %zu\n", size());
     }
 
+    /**
+     * Empties the table, in O(1) if it is GenerationTagged, see
+     * generation.h, and rewinds the slabs. Must not run concurrently with
+     * other operations on the table.
+     */
+    void clear() {
+        _tags.clear(_map, mapBytes());
+        _slabManager.reset();
+    }
+
     void thread_init() {
         _slabManager.thread_init();
     }
 
-    HashTableEntry<K,V>* createHTE(size_t length, const char* keyData, V const& value) {
-        HTE* hte = new(_slabManager.alloc<4>(sizeof(HTE) + length)) HTE(length, keyData, value);
+    HashTableEntry<K,V,KEYS>* createHTE(size_t length, const char* keyData, V const& value) {
+        HTE* hte = new(_slabManager.alloc<4>(sizeof(HTE) + hashtables::KeyStorage<KEYS>::extraBytes(length))) HTE(length, keyData, value);
         assert( (((intptr_t)hte)&0x3) == 0);
         return hte;
     }
 
-    ~HashTable() {
-        munmap(_map, _buckets * _bucketSize);
+    ~BasicHashTable() {
+        munmap(_map, mapBytes());
+    }
+
+    size_t mapBytes() const {
+        return _buckets * _bucketSize + _probeLimit.stashSlots * sizeof(std::atomic<HTE*>);
     }
 
     template<typename CONTAINER>
@@ -230,7 +293,7 @@ public:
                 size_t bucketSize = 0;
 
                 for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                    if(_map[idx+b].load(std::memory_order_relaxed)) {
+                    if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                         bucketSize++;
                     }
                 }
@@ -263,7 +326,7 @@ public:
             size_t bucketSize = 0;
 
             for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                if(_map[idx+b].load(std::memory_order_relaxed)) {
+                if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                     bucketSize++;
                 }
             }
@@ -288,7 +351,9 @@ private:
     size_t const _bucketsMask;
     size_t const _entries;
     size_t const _entriesMask;
-    std::atomic<HashTableEntry<K,V>*>* _map;
+    hashtables::ProbeLimit const _probeLimit;
+    std::atomic<HashTableEntry<K,V,KEYS>*>* _map;
+    TAGS _tags;
     SlabManager _slabManager;
 
 private:
@@ -296,6 +361,15 @@ private:
     static size_t constexpr _entriesPerBucket = _bucketSize/sizeof(void*);
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::CopiedKeys>;
+
+template<typename K, typename V>
+using ExternalKeyHashTable = BasicHashTable<K, V, hashtables::ExternalKeys>;
+
+template<typename K, typename V>
+using GenerationTaggedHashTable = BasicHashTable<K, V, hashtables::CopiedKeys, hashtables::GenerationTagged>;
+
 }
 
 namespace mmapquadtableCUV0 {
@@ -323,18 +397,19 @@ public:
     char _keyData[0];
 };
 
-template<typename K, typename V>
-class HashTable {
+template<typename K, typename V, typename TAGS = hashtables::Untagged>
+class BasicHashTable {
 public:
 
     using HTE = HashTableEntry<K,V>;
 
-    HashTable(size_t bucketsScale)
+    BasicHashTable(size_t bucketsScale)
     : _bucketsScale(bucketsScale)
     , _buckets((1ULL << _bucketsScale)/_entriesPerBucket)
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask( (_entries-1ULL))
+    , _slabManager(SlabPolicy::forScale(bucketsScale))
     {
         _map = (decltype(_map))MMapper::mmapForMap(_buckets * _bucketSize);
     }
@@ -342,7 +417,17 @@ public:
 
     template<typename T>
     static size_t getHash(T* ptr) {
-        return ((intptr_t)ptr & 0xFFFF000000000000ULL);
+        return ((intptr_t)ptr & TAGS::HASH_MASK);
+    }
+
+    /**
+     * Slots hold 16 bits hash and a 48 bit pointer, with TAGS =
+     * GenerationTagged 8 bits generation, 8 bits hash and the pointer, see
+     * generation.h.
+     */
+    template<typename T>
+    bool isLive(T* ptr) const {
+        return _tags.isLive(ptr);
     }
 
     template<typename T>
@@ -366,7 +451,7 @@ public:
 
         size_t length = hashtables::key_accessor<K>::size(key);
 
-        while(current) {
+        while(isLive(current)) {
             size_t currentHash = getHash(current);
             current = getPtr(current);
             if(currentHash == h16l) {
@@ -384,9 +469,10 @@ public:
         }
 
         HashTableEntry<K,V>* hte = createHTE(length, hashtables::key_accessor<K>::data(key), value);
-        HashTableEntry<K,V>* hteWithHash = makePtrWithHash(hte, h16l);
-        while(!_map[e].compare_exchange_weak(current, hteWithHash, std::memory_order_release, std::memory_order_relaxed)) {
-            while(current) {
+        HashTableEntry<K,V>* hteWithHash = makePtrWithHash(hte, h16l | _tags.tag());
+        CasStats::Op cas;
+        while(!cas.weak(_map[e], current, hteWithHash, std::memory_order_release, std::memory_order_relaxed)) {
+            while(isLive(current)) {
                 size_t currentHash = getHash(current);
                 current = getPtr(current);
                 if(currentHash == h16l) {
@@ -416,7 +502,7 @@ public:
 
         size_t length = hashtables::key_accessor<K>::size(key);
 
-        while(current) {
+        while(isLive(current)) {
             size_t currentHash = getHash(current);
             current = getPtr(current);
             if(currentHash == h16l) {
@@ -439,7 +525,7 @@ public:
     size_t hash16LeftFromHash(size_t h) const {
 //        h ^= h << 32ULL;
 //        h ^= h << 16ULL;
-        return h & 0xFFFF000000000000ULL;
+        return h & TAGS::HASH_MASK;
     }
 
     size_t entryFromhash(size_t const& h) {
@@ -476,6 +562,16 @@ public:
         printf("size = %zu\n", size());
     }
 
+    /**
+     * Empties the table, in O(1) if it is GenerationTagged, see
+     * generation.h, and rewinds the slabs. Must not run concurrently with
+     * other operations on the table.
+     */
+    void clear() {
+        _tags.clear(_map, _buckets * _bucketSize);
+        _slabManager.reset();
+    }
+
     void thread_init() {
         _slabManager.thread_init();
     }
@@ -486,7 +582,7 @@ public:
         return hte;
     }
 
-    ~HashTable() {
+    ~BasicHashTable() {
         munmap(_map, _buckets * _bucketSize);
     }
 
@@ -504,7 +600,7 @@ public:
                 size_t bucketSize = 0;
 
                 for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                    if(_map[idx+b].load(std::memory_order_relaxed)) {
+                    if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                         bucketSize++;
                     }
                 }
@@ -537,7 +633,7 @@ public:
             size_t bucketSize = 0;
 
             for(size_t b = 0; b < _entriesPerBucket; ++b) {
-                if(_map[idx+b].load(std::memory_order_relaxed)) {
+                if(isLive(_map[idx+b].load(std::memory_order_relaxed))) {
                     bucketSize++;
                 }
             }
@@ -563,6 +659,7 @@ private:
     size_t const _entries;
     size_t const _entriesMask;
     std::atomic<HashTableEntry<K,V>*>* _map;
+    TAGS _tags;
     SlabManager _slabManager;
 
 private:
@@ -570,4 +667,10 @@ private:
     static size_t constexpr _entriesPerBucket = _bucketSize/sizeof(void*);
 };
 
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::Untagged>;
+
+template<typename K, typename V>
+using GenerationTaggedHashTable = BasicHashTable<K, V, hashtables::GenerationTagged>;
+
 }
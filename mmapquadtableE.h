@@ -0,0 +1,621 @@
+#pragma once
+
+// mmapquadtableCUV that grows by extendible hashing: instead of one bucket
+// array, the table is a directory of segments of 2^--segment_scale slots
+// (default 16), each its own mapping, probed as mmapquadtableCUV probes its
+// array. The directory has 2^depth entries and a key goes to the segment of
+// the top depth bits of its mixed hash. A segment with local depth d is
+// shared by the 2^(depth - d) entries that agree in the top d bits.
+//
+// Slot: 16 bits hash, 48 bit pointer. 0 is empty, FROZEN a frozen empty slot.
+//
+// A segment splits when an insert runs out of probes (--max_probes, see
+// probing.h) or when its inserts, counted on a 1/8 sample of the keys, pass
+// --grow_load (default 0.6) of its slots. The splitting thread maps two
+// segments of depth d + 1, doubling the directory first if d was its depth,
+// freezes every empty slot of the old segment with a CAS, copies the
+// pointers over by the next bit of their hash and then points the directory
+// entries of the old segment at the two new ones. The copies stay within the
+// probe limit as well: a half they do not fit in is split again before
+// anything is published, and a segment at MAX_DEPTH they do not fit in is
+// probed to its end from then on. Entries keep their hash,
+// so nothing is rehashed and no key is copied: a split costs one segment,
+// whatever the size of the table. Splits are serialised by one lock, which
+// only splitting threads take.
+//
+// An insert that runs into a frozen slot waits for the split of that segment
+// to finish and retries from the directory, so only inserts into the
+// splitting segment ever wait. Lookups never wait: the occupied slots of a
+// frozen segment stay as they are, and a lookup that reaches a frozen slot,
+// or the end of its probes, continues from the directory once the split was
+// published; until then the key was not inserted yet.
+//
+// Lookups may still be reading an old segment or directory after a split, so
+// these are only freed by reclaim(), which must not run concurrently with
+// other operations, or by the destructor. Depth is at most MAX_DEPTH; a
+// segment at that depth does not split and tryInsert() reports FULL.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+#include <xmmintrin.h>
+
+#include "allocator.h"
+#include "casstats.h"
+#include "mmapper.h"
+#include "murmurhash.h"
+#include "probing.h"
+#include "key_accessor.h"
+#include "key_storage.h"
+
+namespace mmapquadtableE {
+
+template<typename K, typename V, typename KEYS = hashtables::CopiedKeys>
+class HashTableEntry {
+public:
+
+    HashTableEntry(size_t hash, size_t length, const char* keyData, V const& value): _hash(hash), _value(value), _key(length, keyData) {
+    }
+
+    size_t size() const {
+        return sizeof(HashTableEntry) + hashtables::KeyStorage<KEYS>::extraBytes(_key.length());
+    }
+
+    bool matches(size_t length, const char* keyData) const {
+        return _key.matches(length, keyData);
+    }
+
+public:
+    size_t _hash;   // kept so a split does not rehash the key
+    V _value;
+    hashtables::KeyStorage<KEYS> _key;
+};
+
+/**
+ * KEYS selects whether entries hold a copy of the key bytes (CopiedKeys) or
+ * refer to the bytes of the inserted key (ExternalKeys), see key_storage.h.
+ */
+template<typename K, typename V, typename KEYS = hashtables::CopiedKeys>
+class BasicHashTable {
+public:
+
+    using HTE = HashTableEntry<K,V,KEYS>;
+
+    static constexpr size_t HASH_MASK = 0xFFFF000000000000ULL;
+    static constexpr size_t PTR_MASK = 0x0000FFFFFFFFFFFFULL;
+    static constexpr size_t EMPTY = 0;
+    static constexpr size_t FROZEN = 1;
+
+    static constexpr size_t MAX_DEPTH = 16;
+    static constexpr size_t SAMPLE_BITS = 3;
+
+    BasicHashTable(size_t bucketsScale)
+    : _segmentScale(segmentScaleFromSettings())
+    , _segmentEntries(1ULL << _segmentScale)
+    , _segmentMask(_segmentEntries - 1ULL)
+    , _probeLimit{hashtables::ProbeLimit::fromSettings(_segmentEntries).maxProbes, 0}
+    , _splitAt(_segmentEntries * maxLoadFromSettings())
+    , _slabManager(SlabPolicy::forScale(bucketsScale))
+    {
+        size_t depth = bucketsScale > _segmentScale ? std::min(bucketsScale - _segmentScale, MAX_DEPTH) : 0;
+        Directory* dir = new Directory(depth);
+        for(size_t i = 0; i < dir->size(); ++i) {
+            dir->segments[i].store(new Segment(depth, i, *this), std::memory_order_relaxed);
+        }
+        _directory.store(dir, std::memory_order_release);
+    }
+
+    BasicHashTable(BasicHashTable const&) = delete;
+    BasicHashTable& operator=(BasicHashTable const&) = delete;
+
+    ~BasicHashTable() {
+        Directory* dir = _directory.load(std::memory_order_relaxed);
+        forEachSegment(*dir, [](Segment* segment) {
+            delete segment;
+        });
+        delete dir;
+        reclaim();
+    }
+
+    template<typename T>
+    static T* getPtr(T* ptr) {
+        return (T*)((intptr_t)ptr & PTR_MASK);
+    }
+
+    template<typename T>
+    static size_t getHash(T* ptr) {
+        return (intptr_t)ptr & HASH_MASK;
+    }
+
+    template<typename T>
+    static T* makePtrWithHash(T* ptr, size_t h) {
+        return (T*)(((intptr_t)ptr)|h);
+    }
+
+    size_t hash(K const& key) {
+        return MurmurHash64(key);
+    }
+
+    /**
+     * The directory, the slot hash and the sample take different bits of
+     * this, and the position in a segment the low bits of the hash itself.
+     * Mixed first: MurmurHash64 of an integer is the integer itself.
+     */
+    static size_t mix(size_t h) {
+        return h * 0x9E3779B97F4A7C15ULL;
+    }
+
+    static size_t hash16LeftFromMixed(size_t m) {
+        return (m << 16) & HASH_MASK;
+    }
+
+    size_t insert(K const& key, V const& value) {
+        V result;
+        tryInsert(key, value, result);
+        return result;
+    }
+
+    /**
+     * Inserts key unless it is there already. result is the value in the
+     * table afterwards, or value if the table is FULL: the segment of key is
+     * at MAX_DEPTH and has no free slot within the probe limit.
+     */
+    hashtables::InsertResult tryInsert(K const& key, V const& value, V& result) {
+        size_t h = hash(key);
+        size_t m = mix(h);
+        size_t length = hashtables::key_accessor<K>::size(key);
+        HTE* hte = nullptr;
+        while(true) {
+            Segment* segment = segmentOf(m);
+            switch(insertInto(*segment, h, m, key, length, value, result, hte)) {
+                case Outcome::INSERTED:
+                    if(count(*segment, m)) split(segment);
+                    return hashtables::InsertResult::INSERTED;
+                case Outcome::FOUND:
+                    freeHTE(hte, length);
+                    return hashtables::InsertResult::FOUND;
+                case Outcome::FROZEN:
+                    waitForSplit(*segment);
+                    break;
+                case Outcome::FULL:
+                    if(!split(segment)) {
+                        freeHTE(hte, length);
+                        result = value;
+                        return hashtables::InsertResult::FULL;
+                    }
+                    break;
+            }
+        }
+    }
+
+    bool get(K const& key, V& value) {
+        size_t h = hash(key);
+        size_t m = mix(h);
+        size_t h16l = hash16LeftFromMixed(m);
+        size_t length = hashtables::key_accessor<K>::size(key);
+        while(true) {
+            Segment* segment = segmentOf(m);
+            size_t slot = h & _segmentMask;
+            Sequence sequence(slot, _segmentMask);
+            hashtables::Probe probe(segment->probeLimit, _segmentEntries);
+            HTE* current = segment->slots[slot].load(std::memory_order_acquire);
+            while(true) {
+                if((size_t)current == EMPTY) return false;
+                if((size_t)current == FROZEN) break;
+                if(getHash(current) == h16l && getPtr(current)->matches(length, hashtables::key_accessor<K>::data(key))) {
+                    value = getPtr(current)->_value;
+                    return true;
+                }
+                if(!probe.next(slot, sequence)) break;
+                current = segment->slots[slot].load(std::memory_order_acquire);
+            }
+            if(!segment->split.load(std::memory_order_acquire)) return false;
+        }
+    }
+
+    void thread_init() {
+        _slabManager.thread_init();
+    }
+
+    /**
+     * Frees the segments that were split and the directories that were
+     * doubled. Must not run concurrently with other operations on the table.
+     */
+    void reclaim() {
+        std::lock_guard<std::mutex> lock(_splitLock);
+        for(Segment* segment: _retiredSegments) {
+            delete segment;
+        }
+        _retiredSegments.clear();
+        for(Directory* dir: _retiredDirectories) {
+            delete dir;
+        }
+        _retiredDirectories.clear();
+    }
+
+    size_t depth() const {
+        return _directory.load(std::memory_order_acquire)->depth;
+    }
+
+    size_t segments() {
+        size_t n = 0;
+        forEachSegment(*_directory.load(std::memory_order_acquire), [&n](Segment*) {
+            n++;
+        });
+        return n;
+    }
+
+    size_t splits() {
+        std::lock_guard<std::mutex> lock(_splitLock);
+        return _splits;
+    }
+
+    struct stats {
+        size_t size;
+        size_t usedBuckets;
+        size_t collisions;
+        size_t biggestBucket;
+        double avgBucketSize;
+    };
+
+    /**
+     * Counts all segments in buckets of a cache line, as mmapquadtableCUV
+     * does.
+     */
+    void getStats(stats& s) {
+        s.size = 0;
+        s.usedBuckets = 0;
+        s.collisions = 0;
+        s.biggestBucket = 0;
+        s.avgBucketSize = 0.0;
+
+        size_t buckets = 0;
+        forEachSegment(*_directory.load(std::memory_order_acquire), [&](Segment* segment) {
+            for(size_t idx = 0; idx < _segmentEntries; idx += _entriesPerBucket) {
+                size_t bucketSize = 0;
+
+                for(size_t b = 0; b < _entriesPerBucket; ++b) {
+                    size_t p = (size_t)segment->slots[idx+b].load(std::memory_order_relaxed);
+                    if(p != EMPTY && p != FROZEN) {
+                        bucketSize++;
+                    }
+                }
+
+                if(bucketSize > 0) {
+                    s.usedBuckets++;
+                    s.size += bucketSize;
+                    s.collisions += bucketSize - 1;
+                    if(bucketSize > s.biggestBucket) s.biggestBucket = bucketSize;
+                }
+                buckets++;
+            }
+        });
+
+        if(buckets > 0) {
+            s.avgBucketSize = (double)s.size / (double)buckets;
+        }
+    }
+
+private:
+
+    enum class Outcome {
+        INSERTED,
+        FOUND,
+        FULL,   // no free slot within the probe limit
+        FROZEN, // ran into a slot a split had frozen
+    };
+
+    struct Segment {
+
+        Segment(size_t depth_, size_t prefix_, BasicHashTable const& table)
+        : depth(depth_)
+        , prefix(prefix_)
+        , bytes(table._segmentEntries * sizeof(std::atomic<HTE*>))
+        , slots((std::atomic<HTE*>*)MMapper::mmapForMap(bytes))
+        , probeLimit(table._probeLimit)
+        , split(false)
+        , sampledInserts(0)
+        {
+        }
+
+        ~Segment() {
+            MMapper::munmap(slots, bytes);
+        }
+
+        size_t const depth;     // local depth
+        size_t const prefix;    // the top depth bits of the mixed hash of its keys
+        size_t const bytes;
+        std::atomic<HTE*>* const slots;
+        hashtables::ProbeLimit probeLimit;  // only raised before it is published
+        std::atomic<bool> split;
+
+        // Written while the table is in use, so kept off the line above
+        char padding0[64];
+        std::atomic<size_t> sampledInserts;
+        char padding1[64];
+    };
+
+    struct Directory {
+
+        Directory(size_t depth_)
+        : depth(depth_)
+        , segments(new std::atomic<Segment*>[size()])
+        {
+        }
+
+        ~Directory() {
+            delete[] segments;
+        }
+
+        size_t size() const {
+            return 1ULL << depth;
+        }
+
+        size_t indexOf(size_t m) const {
+            return (m >> 1) >> (63 - depth);
+        }
+
+        size_t const depth;
+        std::atomic<Segment*>* const segments;
+    };
+
+    /**
+     * The quadratic probe sequence of mmapquadtableCUV over the cache line
+     * buckets of a segment.
+     */
+    class Sequence {
+    public:
+
+        Sequence(size_t slot, size_t mask)
+        : _mask(mask)
+        , _base(slot & ~(_entriesPerBucket-1))
+        , _e(slot - _base)
+        , _end(_e)
+        , _increment(0)
+        {
+        }
+
+        __attribute__((always_inline))
+        size_t operator()() {
+            _e = (_e+1) & (_entriesPerBucket-1);
+            if(_e==_end) {
+                _base += _entriesPerBucket * (1 + _increment * 2);
+                _base &= _mask;
+                _increment++;
+            }
+            return _base+_e;
+        }
+
+    private:
+        size_t const _mask;
+        size_t _base;
+        size_t _e;
+        size_t const _end;
+        size_t _increment;
+    };
+
+    static size_t segmentScaleFromSettings() {
+        std::string scale = Settings::global()["segment_scale"].asString();
+        return scale.empty() ? 16 : std::max<size_t>(std::stoul(scale), 3);
+    }
+
+    static double maxLoadFromSettings() {
+        std::string load = Settings::global()["grow_load"].asString();
+        return load.empty() ? 0.6 : std::stod(load);
+    }
+
+    __attribute__((always_inline))
+    Segment* segmentOf(size_t m) {
+        Directory* dir = _directory.load(std::memory_order_acquire);
+        return dir->segments[dir->indexOf(m)].load(std::memory_order_acquire);
+    }
+
+    /**
+     * Calls f(segment) once for every segment of dir.
+     */
+    template<typename F>
+    static void forEachSegment(Directory& dir, F&& f) {
+        for(size_t i = 0; i < dir.size();) {
+            Segment* segment = dir.segments[i].load(std::memory_order_acquire);
+            f(segment);
+            i += 1ULL << (dir.depth - segment->depth);
+        }
+    }
+
+    /**
+     * The entry is only allocated once a free slot was found, and kept for
+     * the retries after a split.
+     */
+    __attribute__((always_inline))
+    Outcome insertInto(Segment& segment, size_t h, size_t m, K const& key, size_t length, V const& value, V& result, HTE*& hte) {
+        size_t h16l = hash16LeftFromMixed(m);
+        size_t slot = h & _segmentMask;
+        Sequence sequence(slot, _segmentMask);
+        hashtables::Probe probe(segment.probeLimit, _segmentEntries);
+        HTE* current = segment.slots[slot].load(std::memory_order_acquire);
+        CasStats::Op cas;
+        while(true) {
+            if((size_t)current == EMPTY) {
+                if(!hte) hte = createHTE(h, length, hashtables::key_accessor<K>::data(key), value);
+                if(cas.strong(segment.slots[slot], current, makePtrWithHash(hte, h16l), std::memory_order_release, std::memory_order_acquire)) {
+                    result = value;
+                    return Outcome::INSERTED;
+                }
+                continue;
+            }
+            if((size_t)current == FROZEN) return Outcome::FROZEN;
+            if(getHash(current) == h16l && getPtr(current)->matches(length, hashtables::key_accessor<K>::data(key))) {
+                result = getPtr(current)->_value;
+                return Outcome::FOUND;
+            }
+            if(!probe.next(slot, sequence)) return Outcome::FULL;
+            current = segment.slots[slot].load(std::memory_order_acquire);
+        }
+    }
+
+    /**
+     * Counts an insert into segment if m is in the sample. Returns whether
+     * the segment is over its load.
+     */
+    __attribute__((always_inline))
+    bool count(Segment& segment, size_t m) {
+        if((m >> 16) & ((1ULL << SAMPLE_BITS) - 1)) return false;
+        size_t n = segment.sampledInserts.fetch_add(1, std::memory_order_relaxed) + 1;
+        return (n << SAMPLE_BITS) > _splitAt;
+    }
+
+    void waitForSplit(Segment& segment) {
+        while(!segment.split.load(std::memory_order_acquire)) {
+            _mm_pause();
+        }
+    }
+
+    /**
+     * Splits segment unless another thread already did. Returns false if it
+     * cannot be split, being at MAX_DEPTH.
+     */
+    __attribute__((noinline))
+    bool split(Segment* segment) {
+        std::lock_guard<std::mutex> lock(_splitLock);
+        if(segment->split.load(std::memory_order_relaxed)) return true;
+        if(segment->depth == MAX_DEPTH) return false;
+
+        std::vector<HTE*> entries;
+        for(size_t e = 0; e < _segmentEntries; ++e) {
+            HTE* current = freeze(segment->slots[e]);
+            if((size_t)current != EMPTY) entries.push_back(current);
+        }
+        std::vector<Segment*> built;
+        build(entries, segment->depth + 1, segment->prefix, built);
+
+        Directory* dir = _directory.load(std::memory_order_relaxed);
+        size_t depth = 0;
+        for(Segment* s: built) depth = std::max(depth, s->depth);
+        while(dir->depth < depth) {
+            Directory* doubled = new Directory(dir->depth + 1);
+            for(size_t i = 0; i < doubled->size(); ++i) {
+                doubled->segments[i].store(dir->segments[i >> 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            _directory.store(doubled, std::memory_order_release);
+            _retiredDirectories.push_back(dir);
+            dir = doubled;
+        }
+
+        // A segment of depth d has the 2^(dir->depth - d) entries from its
+        // prefix on
+        for(Segment* s: built) {
+            size_t span = 1ULL << (dir->depth - s->depth);
+            size_t first = s->prefix << (dir->depth - s->depth);
+            for(size_t i = 0; i < span; ++i) {
+                dir->segments[first + i].store(s, std::memory_order_release);
+            }
+        }
+        segment->split.store(true, std::memory_order_release);
+        _retiredSegments.push_back(segment);
+        _splits += built.size() - 1;
+        return true;
+    }
+
+    /**
+     * Builds the segments of depth that take the entries of a split of the
+     * segment with the given prefix, one for each value of the next bit of
+     * their hash. A segment the entries do not fit in within its probe limit
+     * is split again, or, at MAX_DEPTH, gets the whole segment as its limit.
+     */
+    void build(std::vector<HTE*> const& entries, size_t depth, size_t prefix, std::vector<Segment*>& built) {
+        std::vector<HTE*> halves[2];
+        for(HTE* current: entries) {
+            halves[(mix(getPtr(current)->_hash) >> (64 - depth)) & 1].push_back(current);
+        }
+        for(size_t half = 0; half < 2; ++half) {
+            Segment* segment = new Segment(depth, prefix << 1 | half, *this);
+            bool fits = true;
+            for(HTE* current: halves[half]) {
+                if(moveInto(*segment, current)) continue;
+                if(depth < MAX_DEPTH) {
+                    fits = false;
+                    break;
+                }
+                segment->probeLimit.maxProbes = _segmentEntries;
+                moveInto(*segment, current);
+            }
+            if(fits) {
+                built.push_back(segment);
+            } else {
+                delete segment;
+                build(halves[half], depth + 1, prefix << 1 | half, built);
+            }
+        }
+    }
+
+    /**
+     * Freezes slot if it is empty. Returns what it holds then.
+     */
+    static HTE* freeze(std::atomic<HTE*>& slot) {
+        HTE* current = slot.load(std::memory_order_acquire);
+        while((size_t)current == EMPTY
+           && !slot.compare_exchange_weak(current, (HTE*)FROZEN, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        }
+        return current;
+    }
+
+    /**
+     * Copies a slot into a segment that is not published yet, so only the
+     * splitting thread writes there and no key is in it twice. Returns false
+     * if there is no free slot within the probe limit of the segment.
+     */
+    bool moveInto(Segment& to, HTE* ptrWithHash) {
+        size_t slot = getPtr(ptrWithHash)->_hash & _segmentMask;
+        Sequence sequence(slot, _segmentMask);
+        hashtables::Probe probe(to.probeLimit, _segmentEntries);
+        while(to.slots[slot].load(std::memory_order_relaxed) != nullptr) {
+            if(!probe.next(slot, sequence)) return false;
+        }
+        to.slots[slot].store(ptrWithHash, std::memory_order_relaxed);
+        count(to, mix(getPtr(ptrWithHash)->_hash));
+        return true;
+    }
+
+    HTE* createHTE(size_t h, size_t length, const char* keyData, V const& value) {
+        HTE* hte = new(_slabManager.alloc<4>(sizeof(HTE) + hashtables::KeyStorage<KEYS>::extraBytes(length))) HTE(h, length, keyData, value);
+        assert( (((intptr_t)hte)&0x3) == 0);
+        return hte;
+    }
+
+    /**
+     * Hands back an entry that did not make it into the table. Nothing was
+     * allocated after it, so it can go back.
+     */
+    void freeHTE(HTE* hte, size_t length) {
+        if(hte) _slabManager.free(hte, sizeof(HTE) + hashtables::KeyStorage<KEYS>::extraBytes(length));
+    }
+
+private:
+    size_t const _segmentScale;
+    size_t const _segmentEntries;
+    size_t const _segmentMask;
+    hashtables::ProbeLimit const _probeLimit;
+    size_t const _splitAt;
+    std::atomic<Directory*> _directory;
+    SlabManager _slabManager;
+    std::mutex _splitLock;
+    std::vector<Segment*> _retiredSegments;
+    std::vector<Directory*> _retiredDirectories;
+    size_t _splits = 0;
+
+private:
+    static size_t constexpr _entriesPerBucket = 64 / sizeof(void*);
+};
+
+template<typename K, typename V>
+using HashTable = BasicHashTable<K, V, hashtables::CopiedKeys>;
+
+template<typename K, typename V>
+using ExternalKeyHashTable = BasicHashTable<K, V, hashtables::ExternalKeys>;
+
+}
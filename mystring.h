@@ -127,3 +127,73 @@ struct MurmurHasher<my_string> {
         return k.hash();
     }
 };
+
+/**
+ * A string key that does not own its bytes: a pointer and a length into data
+ * that outlives the key, such as a mapped input file. Copies are plain
+ * copies of the pair.
+ */
+struct my_string_ref {
+    const char* s;
+    size_t len;
+
+    my_string_ref(): s(nullptr), len(0) {
+    }
+
+    my_string_ref(const char* s, size_t len): s(s), len(len) {
+    }
+
+    bool operator==(my_string_ref const& other) const {
+        if(len != other.len) return false;
+        return memcmp(s, other.s, len) == 0;
+    }
+
+    size_t hash() const {
+        return MurmurHash64(s, len, 0);
+    }
+};
+
+namespace std {
+
+template <>
+struct hash<my_string_ref> {
+    std::size_t operator()(my_string_ref const& k) const {
+        return k.hash();
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const my_string_ref& obj) {
+    out.write(obj.s, obj.len);
+    return out;
+}
+
+}
+
+namespace hashtables {
+
+template<>
+struct key_accessor<my_string_ref> {
+    static const char* data(my_string_ref const& key) {
+        return key.s;
+    }
+    static size_t size(my_string_ref const& key) {
+        return key.len;
+    }
+};
+
+}
+
+template<>
+uint64_t MurmurHash64<my_string_ref> ( my_string_ref const& key ) {
+    return MurmurHash64(key.s, key.len, 0);
+}
+
+template<>
+struct MurmurHasher<my_string_ref> {
+    static const size_t significant_digits = 64;
+
+    inline uint64_t operator()(my_string_ref const& k) const
+    {
+        return k.hash();
+    }
+};
@@ -12,6 +12,7 @@
 #include "mmapper.h"
 #include "murmurhash.h"
 #include "key_accessor.h"
+#include "probing.h"
 
 #define CACHE_LINE_SIZE_BP2 6
 #define CACHE_LINE_SIZE_IN_BYTES (1<<CACHE_LINE_SIZE_BP2)
@@ -80,6 +81,8 @@ struct QuadraticCacheLinearBucketSearchStart0 {
         : _ht(ht)
         , _e(e)
         , _increment(0)
+        , _probe(ht._probeLimit, ht._entries)
+        , _full(false)
         {
         _e &= (HT::_entriesPerBucket-1);
     }
@@ -91,20 +94,34 @@ struct QuadraticCacheLinearBucketSearchStart0 {
                 current = _ht.getPtr(current);
                 return true;
             }
-            _e++;
-            if((_e & (HT::_entriesPerBucket-1)) == 0) {
-                _e += HT::_entriesPerBucket * (2 * _increment);
-                _e &= _ht._entriesMask;
-                _increment++;
-            }
+            if(!_probe.next(_e, [this]() {
+                _e++;
+                if((_e & (HT::_entriesPerBucket-1)) == 0) {
+                    _e += HT::_entriesPerBucket * (2 * _increment);
+                    _e &= _ht._entriesMask;
+                    _increment++;
+                }
+                return _e;
+            })) break;
             current = _ht._map[_e].load(std::memory_order_relaxed);
         }
+        _full = current != nullptr;
         return false;
     }
 
+    /**
+     * Whether the last next() gave up because the probe limit and the stash
+     * were exhausted, rather than because it reached an empty slot.
+     */
+    bool full() const {
+        return _full;
+    }
+
     HT& _ht;
     size_t& _e;
     size_t _increment;
+    hashtables::Probe _probe;
+    bool _full;
 };
 
 template<typename HT>
@@ -114,6 +131,8 @@ struct LinearCacheLinearBucketSearchStart0 {
         : _ht(ht)
         , _e(e)
         , _end(e)
+        , _probe(ht._probeLimit, ht._entries)
+        , _full(false)
         {
         _e &= (HT::_entriesPerBucket-1);
     }
@@ -125,16 +144,22 @@ struct LinearCacheLinearBucketSearchStart0 {
                 current = _ht.getPtr(current);
                 return true;
             }
-            _e++;
-            _e &= _ht._entriesMask;
+            if(!_probe.next(_e, [this]() { return (_e+1) & _ht._entriesMask; })) break;
             current = _ht._map[_e].load(std::memory_order_relaxed);
         }
+        _full = current != nullptr;
         return false;
     }
 
+    bool full() const {
+        return _full;
+    }
+
     HT& _ht;
     size_t& _e;
     size_t _end;
+    hashtables::Probe _probe;
+    bool _full;
 };
 
 template<typename HT>
@@ -146,6 +171,8 @@ struct QuadraticCacheLinearBucketSearch {
         , _base(e & ~(HT::_entriesPerBucket-1))
         , _increment(0)
         , _end(e & (HT::_entriesPerBucket-1))
+        , _probe(ht._probeLimit, ht._entries)
+        , _full(false)
         {
 //        _e -= _base;
     }
@@ -157,24 +184,33 @@ struct QuadraticCacheLinearBucketSearch {
                 current = _ht.getPtr(current);
                 return true;
             }
-            _e -= _base;
-            _e = (_e+1) & (HT::_entriesPerBucket-1);
-            if(_e==_end) {
-                _base += HT::_entriesPerBucket * (2 * _increment + 1);
-                _base &= _ht._entriesMask;
-                _increment++;
-            }
-            _e += _base;
+            if(!_probe.next(_e, [this]() {
+                _e -= _base;
+                _e = (_e+1) & (HT::_entriesPerBucket-1);
+                if(_e==_end) {
+                    _base += HT::_entriesPerBucket * (2 * _increment + 1);
+                    _base &= _ht._entriesMask;
+                    _increment++;
+                }
+                return _e + _base;
+            })) break;
             current = _ht._map[_e].load(std::memory_order_relaxed);
         }
+        _full = current != nullptr;
         return false;
     }
 
+    bool full() const {
+        return _full;
+    }
+
     HT& _ht;
     size_t& _e;
     size_t _base;
     size_t _increment;
     size_t _end;
+    hashtables::Probe _probe;
+    bool _full;
 };
 
 template<typename HT>
@@ -186,6 +222,8 @@ struct LinearCacheLinearBucketSearch {
         , _base(e & ~(HT::_entriesPerBucket-1))
         , _increment(0)
         , _end(e)
+        , _probe(ht._probeLimit, ht._entries)
+        , _full(false)
         {
 //        _e -= _base;
     }
@@ -197,24 +235,33 @@ struct LinearCacheLinearBucketSearch {
                 current = _ht.getPtr(current);
                 return true;
             }
-            _e -= _base;
-            _e = (_e+1) & (HT::_entriesPerBucket-1);
-            if(_e==_end) {
-                _base += HT::_entriesPerBucket;
-                _base &= _ht._entriesMask;
-                _increment++;
-            }
-            _e += _base;
+            if(!_probe.next(_e, [this]() {
+                _e -= _base;
+                _e = (_e+1) & (HT::_entriesPerBucket-1);
+                if(_e==_end) {
+                    _base += HT::_entriesPerBucket;
+                    _base &= _ht._entriesMask;
+                    _increment++;
+                }
+                return _e + _base;
+            })) break;
             current = _ht._map[_e].load(std::memory_order_relaxed);
         }
+        _full = current != nullptr;
         return false;
     }
 
+    bool full() const {
+        return _full;
+    }
+
     HT& _ht;
     size_t& _e;
     size_t _base;
     size_t _increment;
     size_t _end;
+    hashtables::Probe _probe;
+    bool _full;
 };
 
 template<typename HT>
@@ -224,6 +271,8 @@ struct QuadraticSearch {
         : _ht(ht)
         , _e(e)
         , _increment(0)
+        , _probe(ht._probeLimit, ht._entries)
+        , _full(false)
         {
 //        _e -= _base;
     }
@@ -235,17 +284,27 @@ struct QuadraticSearch {
                 current = _ht.getPtr(current);
                 return true;
             }
-            _e += 2 * _increment + 1;
-            _e &= _ht._entriesMask;
-            _increment++;
+            if(!_probe.next(_e, [this]() {
+                _e += 2 * _increment + 1;
+                _e &= _ht._entriesMask;
+                _increment++;
+                return _e;
+            })) break;
             current = _ht._map[_e].load(std::memory_order_relaxed);
         }
+        _full = current != nullptr;
         return false;
     }
 
+    bool full() const {
+        return _full;
+    }
+
     HT& _ht;
     size_t& _e;
     size_t _increment;
+    hashtables::Probe _probe;
+    bool _full;
 };
 
 template<typename HT>
@@ -254,6 +313,8 @@ struct LinearSearch {
     LinearSearch(HT& ht, size_t& e)
         : _ht(ht)
         , _e(e)
+        , _probe(ht._probeLimit, ht._entries)
+        , _full(false)
         {
 //        _e -= _base;
     }
@@ -265,14 +326,21 @@ struct LinearSearch {
                 current = _ht.getPtr(current);
                 return true;
             }
-            _e = (_e+1) & _ht._entriesMask;
+            if(!_probe.next(_e, [this]() { return (_e+1) & _ht._entriesMask; })) break;
             current = _ht._map[_e].load(std::memory_order_relaxed);
         }
+        _full = current != nullptr;
         return false;
     }
 
+    bool full() const {
+        return _full;
+    }
+
     HT& _ht;
     size_t& _e;
+    hashtables::Probe _probe;
+    bool _full;
 };
 
 template< typename K
@@ -303,8 +371,9 @@ public:
     , _bucketsMask((_buckets-1ULL))
     , _entries(_buckets*_entriesPerBucket)
     , _entriesMask( (_entries-1ULL))
+    , _probeLimit(hashtables::ProbeLimit::fromSettings(_entries))
     {
-        _map = (decltype(_map))MMapper::mmapForMap(_buckets * _bucketSize);
+        _map = (decltype(_map))MMapper::mmapForMap(mapBytes());
     }
 public:
 
@@ -324,6 +393,16 @@ public:
     }
 
     size_t insert(K const& key, V const& value) {
+        V result;
+        tryInsert(key, value, result);
+        return result;
+    }
+
+    /**
+     * Inserts key unless it is there already. result is the value in the
+     * table afterwards, or value if the table is FULL, see probing.h.
+     */
+    hashtables::InsertResult tryInsert(K const& key, V const& value, V& result) {
 
         size_t h = Hasher{}(key);
         size_t h16l = KeyComparator::hash16LeftFromHash(h);
@@ -334,7 +413,12 @@ public:
         HashTableEntry<K,V>* current = nullptr;
 
         if(search.next(key, current, h16l)) {
-            return *(V*)(current->_data + current->_lengthKey);
+            result = *(V*)(current->_data + current->_lengthKey);
+            return hashtables::InsertResult::FOUND;
+        }
+        if(search.full()) {
+            result = value;
+            return hashtables::InsertResult::FULL;
         }
 
         size_t keyLength = AccessorKey::size(key);
@@ -345,10 +429,18 @@ public:
         HashTableEntry<K,V>* hteWithHash = makePtrWithHash(hte, h16l);
         while(!_map[e].compare_exchange_weak(current, hteWithHash, std::memory_order_release, std::memory_order_relaxed)) {
             if(search.next(key, current, h16l)) {
-                return *(V*)(current->_data + current->_lengthKey);
+                result = *(V*)(current->_data + current->_lengthKey);
+                return hashtables::InsertResult::FOUND;
+            }
+            if(search.full()) {
+                // Nothing was allocated after hte, so it can go back
+                _slabManager.free(hte, sizeof(HTE) + keyLength + valueLength);
+                result = value;
+                return hashtables::InsertResult::FULL;
             }
         }
-        return value;
+        result = value;
+        return hashtables::InsertResult::INSERTED;
     }
 
     bool get(K const& key, V& value) {
@@ -412,7 +504,11 @@ public:
     }
 
     ~HashTable() {
-        munmap(_map, _buckets * _bucketSize);
+        munmap(_map, mapBytes());
+    }
+
+    size_t mapBytes() const {
+        return _buckets * _bucketSize + _probeLimit.stashSlots * sizeof(std::atomic<HashTableEntry<K,V>*>);
     }
 
     template<typename CONTAINER>
@@ -487,6 +583,7 @@ private:
     size_t const _bucketsMask;
     size_t const _entries;
     size_t const _entriesMask;
+    hashtables::ProbeLimit const _probeLimit;
     std::atomic<HashTableEntry<K,V>*>* _map;
     SlabManager _slabManager;
 
@@ -0,0 +1,129 @@
+#pragma once
+
+// Open-loop variant of the workload driver, selected with --mode=openloop.
+//
+// Every thread issues its operations on a fixed schedule, so that all
+// threads together offer --rate operations per second; --rates=1e6,2e6,...
+// sweeps several rates, each on a freshly loaded table. Latency is measured
+// from the time an operation was scheduled to start, not from when it was
+// issued, so a thread falling behind is charged for the wait of the
+// operations queued after it (correcting for coordinated omission). The
+// operation mix and key choice are those of --mode=workload.
+
+#include <x86intrin.h>
+#include <xmmintrin.h>
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "latency.h"
+#include "workload.h"
+
+template<typename TEST, typename IMPL>
+class OpenLoopTest: public WorkloadTest<TEST, IMPL> {
+public:
+
+    using Base = WorkloadTest<TEST, IMPL>;
+
+    OpenLoopTest(TEST& test, IMPL& impl)
+    : Base(test, impl)
+    {
+    }
+
+    void test() {
+        this->readSettings();
+
+        for(double rate: rates()) {
+            this->_impl.init(this->_bucketScale);
+            this->load();
+            endPhase(this->_impl, "load");
+
+            std::vector<LatencyHistogram> histograms(this->_threads);
+            double ticksPerOp = ticksPerNanosecond() * 1e9 * this->_threads / rate;
+            double runTime = runThreads(this->_threads, [this](size_t tid) { this->_impl.thread_init(tid); }, [this, ticksPerOp, &histograms](size_t tid) {
+                run(tid, ticksPerOp, histograms[tid]);
+            });
+            endPhase(this->_impl, "rate " + std::to_string((size_t)rate));
+
+            this->_impl.cleanup();
+
+            LatencyHistogram merged;
+            for(auto& h: histograms) {
+                merged.merge(h);
+            }
+            double perNs = ticksPerNanosecond();
+            printHeader();
+            std::cout << std::fixed << std::setw( 25 ) << this->_impl.name()
+                      << std::fixed << std::setw(  4 ) << this->_threads
+                      << std::fixed << std::setw(  7 ) << this->_mix.name
+                      << std::fixed << std::setw( 10 ) << merged.samples()
+                      << std::fixed << std::setw(  9 ) << std::setprecision(3) << rate / 1e6
+                      << std::fixed << std::setw(  9 ) << std::setprecision(3) << merged.samples() / runTime / 1e6
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << merged.percentile(0.50) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << merged.percentile(0.90) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << merged.percentile(0.99) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << merged.percentile(0.999) / perNs
+                      << std::fixed << std::setw( 11 ) << std::setprecision(0) << merged.max() / perNs
+                      << std::endl;
+
+            std::string rateName = "rate_" + std::to_string((size_t)rate);
+            Results::get().set("mops." + rateName, merged.samples() / runTime / 1e6);
+            recordLatency("lat." + rateName, merged);
+        }
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "ths"
+                  << std::fixed << std::setw(  7 ) << "wl"
+                  << std::fixed << std::setw( 10 ) << "ops"
+                  << std::fixed << std::setw(  9 ) << "target"
+                  << std::fixed << std::setw(  9 ) << "Mops"
+                  << std::fixed << std::setw(  9 ) << "p50ns"
+                  << std::fixed << std::setw(  9 ) << "p90ns"
+                  << std::fixed << std::setw(  9 ) << "p99ns"
+                  << std::fixed << std::setw(  9 ) << "p99.9ns"
+                  << std::fixed << std::setw( 11 ) << "maxns"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    static std::vector<double> rates() {
+        std::string list = Settings::global()["rates"].asString();
+        if(list.empty()) list = Settings::global()["rate"].asString();
+        std::vector<double> rates;
+        std::stringstream s(list);
+        std::string rate;
+        while(std::getline(s, rate, ',')) {
+            if(!rate.empty() && std::stod(rate) > 0.0) rates.push_back(std::stod(rate));
+        }
+        if(rates.empty()) rates.push_back(1e6);
+        return rates;
+    }
+
+    /**
+     * Issues the operations of thread tid, the n-th one no earlier than
+     * n*ticksPerOp after the start, and records for each the time between
+     * that scheduled start and its completion.
+     */
+    void run(size_t tid, double ticksPerOp, LatencyHistogram& histogram) {
+        Random rng(Random::seedFor(this->_seed, tid));
+        uint64_t start = __rdtsc();
+        for(size_t n = 0; n < this->_operations; ++n) {
+            uint64_t intended = start + (uint64_t)(n * ticksPerOp);
+            while(__rdtsc() < intended) _mm_pause();
+            this->step(tid, rng);
+            histogram.record(__rdtsc() - intended);
+        }
+    }
+};
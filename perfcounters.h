@@ -0,0 +1,345 @@
+#pragma once
+
+// Hardware performance counters through perf_event_open(2), enabled with
+// --perf=1 (totals per phase) or --perf=2 (also every thread).
+//
+// ImplPerf wraps any Impl* and opens a set of counters for each benchmark
+// thread in thread_init(), disabled, and enables them on the first insert()
+// or get() of the thread, so the wait for the other threads at the start of
+// a phase is not counted. Every counter is opened on its own, so events the
+// CPU or the VM does not support are just reported as "-". Counts are user
+// space only and scaled when the kernel had to multiplex them. At the end of
+// each phase the counts are normalized by the number of insert() and get()
+// calls in that phase and printed after the result line of the driver.
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "driver.h"
+#include "results.h"
+
+class PerfCounters {
+public:
+
+    enum Event {
+        CYCLES,
+        INSTRUCTIONS,
+        LLC_MISSES,
+        DTLB_MISSES,
+        REMOTE_DRAM,
+        EVENTS
+    };
+
+    static constexpr const char* eventName(size_t event) {
+        return event == CYCLES       ? "cycles"
+             : event == INSTRUCTIONS ? "instr"
+             : event == LLC_MISSES   ? "LLCmiss"
+             : event == DTLB_MISSES  ? "dTLBmiss"
+             :                         "remote"
+             ;
+    }
+
+    struct Values {
+        double value[EVENTS];
+        bool valid[EVENTS];
+
+        Values() {
+            for(size_t e = 0; e < EVENTS; ++e) {
+                value[e] = 0.0;
+                valid[e] = false;
+            }
+        }
+
+        void add(Values const& other) {
+            for(size_t e = 0; e < EVENTS; ++e) {
+                value[e] += other.value[e];
+                valid[e] |= other.valid[e];
+            }
+        }
+    };
+
+    PerfCounters() {
+        for(int& fd: _fd) fd = -1;
+    }
+
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    ~PerfCounters() {
+        close();
+    }
+
+    /**
+     * Opens the counters for the calling thread, disabled until enable().
+     */
+    void open() {
+        close();
+        for(size_t e = 0; e < EVENTS; ++e) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            describe((Event)e, attr);
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.disabled = 1;
+            _fd[e] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+    }
+
+    void enable() {
+        for(int fd: _fd) {
+            if(fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    /**
+     * Reads the counters. This also works from another thread, and after the
+     * thread that opened them has exited.
+     */
+    Values read() const {
+        Values values;
+        for(size_t e = 0; e < EVENTS; ++e) {
+            uint64_t data[3];
+            if(_fd[e] < 0 || ::read(_fd[e], data, sizeof(data)) != sizeof(data) || !data[2]) continue;
+            values.value[e] = data[2] < data[1] ? (double)data[0] * data[1] / data[2] : (double)data[0];
+            values.valid[e] = true;
+        }
+        return values;
+    }
+
+    void close() {
+        for(int& fd: _fd) {
+            if(fd >= 0) ::close(fd);
+            fd = -1;
+        }
+    }
+
+    bool isOpen() const {
+        for(int fd: _fd) {
+            if(fd >= 0) return true;
+        }
+        return false;
+    }
+
+private:
+
+    static void describe(Event event, struct perf_event_attr& attr) {
+        switch(event) {
+            case CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case LLC_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case DTLB_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            default:
+                // The kernel maps NODE misses to the offcore remote DRAM event where the CPU has one
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_NODE | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+        }
+    }
+
+private:
+    int _fd[EVENTS];
+};
+
+template<typename IMPL>
+class ImplPerf {
+public:
+
+    struct alignas(64) ThreadPerf {
+        PerfCounters counters;
+        PerfCounters::Values values;
+        size_t ops = 0;
+        bool counting = false;
+    };
+
+    struct PhasePerf {
+        std::string name;
+        PerfCounters::Values total;
+        size_t ops;
+        std::vector<PerfCounters::Values> threadValues;
+        std::vector<size_t> threadOps;
+    };
+
+    ImplPerf(IMPL& impl)
+    : _impl(impl)
+    , _perThread(Settings::global()["perf"].asUnsignedValue() > 1)
+    {
+    }
+
+    void init(size_t bucketScale) {
+        _threads = std::vector<ThreadPerf>(Settings::global()["threads"].asUnsignedValue());
+        _impl.init(bucketScale);
+    }
+
+    /**
+     * Drivers may start new threads for every phase, so the counters of an
+     * earlier thread with the same tid are folded in before opening new ones.
+     */
+    void thread_init(int tid) {
+        _tid = tid;
+        ThreadPerf& t = _threads[tid];
+        if(t.counters.isOpen()) {
+            t.values.add(t.counters.read());
+        }
+        _impl.thread_init(tid);
+        t.counters.open();
+        t.counting = false;
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    void insert(K const& k, V const& v) {
+        count(_threads[_tid]);
+        _impl.insert(k, v);
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    bool get(K const& k, V& v) {
+        count(_threads[_tid]);
+        return _impl.get(k, v);
+    }
+
+    void cleanup() {
+        _impl.cleanup();
+    }
+
+    std::string name() const {
+        return _impl.name();
+    }
+
+    void statsString(std::ostream& out, size_t bars) {
+        _impl.statsString(out, bars);
+    }
+
+    void finishPhase(std::string const& phase) {
+        PhasePerf p;
+        p.name = phase;
+        p.ops = 0;
+        for(auto& t: _threads) {
+            if(t.counters.isOpen()) {
+                t.values.add(t.counters.read());
+                t.counters.close();
+            }
+            p.total.add(t.values);
+            p.ops += t.ops;
+            p.threadValues.push_back(t.values);
+            p.threadOps.push_back(t.ops);
+            t.values = PerfCounters::Values();
+            t.ops = 0;
+        }
+        _phases.push_back(std::move(p));
+        endPhase(_impl, phase);
+    }
+
+    /**
+     * Prints the counters per operation for every phase, and for every thread
+     * with --perf=2.
+     */
+    void report() {
+        for(auto& p: _phases) {
+            if(!p.ops) continue;
+            printHeader();
+            printLine(p.name, p.total, p.ops);
+            record("perf." + Results::metricName(p.name), p.total, p.ops);
+            if(!_perThread) continue;
+            for(size_t tid = 0; tid < p.threadValues.size(); ++tid) {
+                printLine(p.name + " t" + std::to_string(tid), p.threadValues[tid], p.threadOps[tid]);
+            }
+        }
+        _phases.clear();
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "counters (per op)"
+                  << std::fixed << std::setw( 10 ) << "ops"
+                  ;
+        for(size_t e = 0; e < PerfCounters::EVENTS; ++e) {
+            std::cout << std::fixed << std::setw(  9 ) << PerfCounters::eventName(e);
+        }
+        std::cout << std::fixed << std::setw(  6 ) << "IPC"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    /**
+     * The first operation of a thread starts its counters.
+     */
+    __attribute__((always_inline))
+    static void count(ThreadPerf& t) {
+        if(__builtin_expect(!t.counting, 0)) {
+            t.counters.enable();
+            t.counting = true;
+        }
+        t.ops++;
+    }
+
+    static void record(std::string const& prefix, PerfCounters::Values const& values, size_t ops) {
+        for(size_t e = 0; e < PerfCounters::EVENTS; ++e) {
+            if(values.valid[e]) Results::get().set(prefix + "." + PerfCounters::eventName(e), values.value[e] / ops);
+        }
+    }
+
+    static void printLine(std::string const& label, PerfCounters::Values const& values, size_t ops) {
+        std::cout << std::fixed << std::setw( 25 ) << label
+                  << std::fixed << std::setw( 10 ) << ops
+                  ;
+        for(size_t e = 0; e < PerfCounters::EVENTS; ++e) {
+            if(values.valid[e] && ops) {
+                std::cout << std::fixed << std::setw(  9 ) << std::setprecision(2) << values.value[e] / ops;
+            } else {
+                std::cout << std::fixed << std::setw(  9 ) << "-";
+            }
+        }
+        if(values.valid[PerfCounters::CYCLES] && values.valid[PerfCounters::INSTRUCTIONS] && values.value[PerfCounters::CYCLES] > 0.0) {
+            std::cout << std::fixed << std::setw(  6 ) << std::setprecision(2) << values.value[PerfCounters::INSTRUCTIONS] / values.value[PerfCounters::CYCLES];
+        } else {
+            std::cout << std::fixed << std::setw(  6 ) << "-";
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    IMPL& _impl;
+    bool _perThread;
+    std::vector<ThreadPerf> _threads;
+    std::vector<PhasePerf> _phases;
+    static __thread int _tid;
+};
+
+template<typename IMPL>
+__thread int ImplPerf<IMPL>::_tid;
+
+template<typename IMPL>
+void endPhase(ImplPerf<IMPL>& impl, std::string const& phase) {
+    impl.finishPhase(phase);
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+// Bounded probing for the open-addressing tables.
+//
+// An operation looks at no more than --max_probes slots of its probe
+// sequence (0, the default, means all entries of the table, so only a truly
+// full table gives up). Keys that find no free slot in that stretch go to
+// the overflow stash: --stash extra slots behind the bucket array, 0 by
+// default, searched linearly from the first. When the stash is taken as
+// well, tryInsert() reports FULL instead of probing forever, and a lookup
+// that got that far reports a miss.
+//
+// The stash shares the mapping of the bucket array, so with --stash > 0 the
+// mapping is no longer a whole number of hugetlbfs pages and uses THP.
+//
+// The benchmark implementations insert through insertCountingFull(), which
+// uses tryInsert() where a table has it and counts the FULL results in
+// FullInserts, so a run can tell how many of its keys were dropped.
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <libfrugi/Settings.h>
+
+using namespace libfrugi;
+
+namespace hashtables {
+
+enum class InsertResult {
+    INSERTED,   // the key was added
+    FOUND,      // the key was there already
+    FULL,       // no free slot within the probe limit, nor in the stash
+};
+
+struct ProbeLimit {
+    size_t maxProbes;   // slots of the probe sequence to look at
+    size_t stashSlots;  // overflow slots behind the entries of the table
+
+    static ProbeLimit fromSettings(size_t entries) {
+        Settings& settings = Settings::global();
+        size_t maxProbes = settings["max_probes"].asUnsignedValue();
+        if(maxProbes == 0 || maxProbes > entries) maxProbes = entries;
+        return ProbeLimit{maxProbes, settings["stash"].asUnsignedValue()};
+    }
+};
+
+/**
+ * Counts the probes of one operation. The slot it starts at is the first
+ * probe. next() moves slot to the next one: along the probe sequence of the
+ * table while the limit allows, then through the stash. It returns false
+ * once the stash is exhausted too.
+ */
+class Probe {
+public:
+
+    Probe(ProbeLimit const& limit, size_t entries)
+    : _left(limit.maxProbes)
+    , _entries(entries)
+    , _stashEnd(entries + limit.stashSlots)
+    {
+    }
+
+    /**
+     * sequence() returns the next slot of the probe sequence of the table.
+     */
+    template<typename SEQUENCE>
+    __attribute__((always_inline))
+    bool next(size_t& slot, SEQUENCE&& sequence) {
+        if(__builtin_expect(_left > 1, 1)) {
+            _left--;
+            slot = sequence();
+            return true;
+        }
+        slot = _left ? _entries : slot + 1;
+        _left = 0;
+        return slot < _stashEnd;
+    }
+
+private:
+    size_t _left;
+    size_t const _entries;
+    size_t const _stashEnd;
+};
+
+
+template<typename... T>
+struct make_void {
+    using type = void;
+};
+
+/**
+ * Whether HT has tryInsert(K const&, V const&, V&) returning an InsertResult.
+ */
+template<typename HT, typename K, typename V, typename = void>
+struct has_try_insert: std::false_type {};
+
+template<typename HT, typename K, typename V>
+struct has_try_insert<HT, K, V, typename make_void<decltype(std::declval<HT&>().tryInsert(std::declval<K const&>(), std::declval<V const&>(), std::declval<V&>()))>::type>: std::true_type {};
+
+/**
+ * Counts the inserts that got FULL back. Counts go to the calling thread and
+ * are folded into the process total when it exits, so read total() after
+ * joining the benchmark threads and take the difference of two reads.
+ */
+class FullInserts {
+public:
+
+    __attribute__((noinline))
+    static void count() {
+        getLocal().full++;
+    }
+
+    /**
+     * The count of all exited threads plus that of the calling thread.
+     */
+    static size_t total() {
+        return global().load(std::memory_order_relaxed) + getLocal().full;
+    }
+
+private:
+
+    struct Local {
+        size_t full = 0;
+
+        ~Local() {
+            global().fetch_add(full, std::memory_order_relaxed);
+        }
+    };
+
+    static Local& getLocal() {
+        static thread_local Local local;
+        return local;
+    }
+
+    static std::atomic<size_t>& global() {
+        static std::atomic<size_t> full(0);
+        return full;
+    }
+};
+
+template<typename HT, typename K, typename V>
+__attribute__((always_inline))
+inline void insertCountingFull(HT& ht, K const& key, V const& value, std::true_type) {
+    V result;
+    if(__builtin_expect(ht.tryInsert(key, value, result) == InsertResult::FULL, 0)) FullInserts::count();
+}
+
+template<typename HT, typename K, typename V>
+__attribute__((always_inline))
+inline void insertCountingFull(HT& ht, K const& key, V const& value, std::false_type) {
+    ht.insert(key, value);
+}
+
+/**
+ * Inserts key into ht, through tryInsert() if HT has it, counting the
+ * inserts that were dropped because the table was FULL.
+ */
+template<typename HT, typename K, typename V>
+__attribute__((always_inline))
+inline void insertCountingFull(HT& ht, K const& key, V const& value) {
+    insertCountingFull(ht, key, value, has_try_insert<HT, K, V>{});
+}
+
+}
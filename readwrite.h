@@ -0,0 +1,236 @@
+#pragma once
+
+// Lookups while the table is being filled, selected with --mode=readwrite.
+//
+// The first --writers threads (default half of --threads) insert all their
+// keys, the other threads look up keys for as long as the writers run. A
+// reader looks up, with probability --read_hits (default 0.5), a key some
+// writer has already inserted, and otherwise one of the keys of the readers,
+// which are never inserted. The reads are split by the fill level of the
+// table at the time of the lookup, in --fill_steps (default 10) steps of the
+// keys of all writers; for every step the read throughput, the share of
+// lookups that found their key and the latency of every --latency_sample'th
+// lookup are printed.
+
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "driver.h"
+#include "latency.h"
+#include "results.h"
+
+template<typename TEST, typename IMPL>
+class ReadWriteTest {
+public:
+
+    struct alignas(64) WriterProgress {
+        std::atomic<size_t> inserted;
+    };
+
+    struct FillStep {
+        size_t reads = 0;
+        size_t found = 0;
+        uint64_t ticks = 0;
+        LatencyHistogram histogram;
+    };
+
+    struct alignas(64) ReaderStats {
+        std::vector<FillStep> steps;
+    };
+
+    ReadWriteTest(TEST& test, IMPL& impl)
+    : _test(test)
+    , _impl(impl)
+    {
+    }
+
+    void test() {
+        Settings& settings = Settings::global();
+        _bucketScale = settings["buckets_scale"].asUnsignedValue();
+        _threads = settings["threads"].asUnsignedValue();
+        if(_threads < 2) {
+            std::cerr << "--mode=readwrite needs at least 2 threads" << std::endl;
+            return;
+        }
+        _inserts = settings["inserts"].asUnsignedValue();
+        _writers = std::max<size_t>(1, std::min(_threads - 1, settingAsUnsigned("writers", _threads / 2)));
+        _hitRatio = std::min(1.0, std::max(0.0, settingAsDouble("read_hits", 0.5)));
+        _fillSteps = std::max<size_t>(1, settingAsUnsigned("fill_steps", 10));
+        _sample = std::max<size_t>(1, settingAsUnsigned("latency_sample", 8));
+        _seed = settingAsUnsigned("seed", 1234567);
+        _test.setup(_bucketScale, _threads, _inserts, settingAsDouble("duplicateratio", 0.0), settingAsDouble("collisionratio", 1.0));
+
+        _progress = std::vector<WriterProgress>(_writers);
+        for(auto& p: _progress) p.inserted.store(0, std::memory_order_relaxed);
+        _filled.store(0, std::memory_order_relaxed);
+        _writersLeft.store(_writers, std::memory_order_relaxed);
+        _readers = std::vector<ReaderStats>(_threads - _writers);
+        for(auto& r: _readers) r.steps.resize(_fillSteps);
+        std::vector<double> writeTimes(_writers);
+
+        _impl.init(_bucketScale);
+        runThreads(_threads, [this](size_t tid) { _impl.thread_init(tid); }, [this, &writeTimes](size_t tid) {
+            if(tid < _writers) {
+                Timer timer;
+                write(tid);
+                writeTimes[tid] = timer.getElapsedSeconds();
+                _writersLeft.fetch_sub(1, std::memory_order_release);
+            } else {
+                read(tid, _readers[tid - _writers]);
+            }
+        });
+        endPhase(_impl, "readwrite");
+        _impl.cleanup();
+
+        double writeTime = *std::max_element(writeTimes.begin(), writeTimes.end());
+        double perNs = ticksPerNanosecond();
+        Results& results = Results::get();
+        results.set("time.insert", writeTime);
+        results.set("mops.insert", _writers * _inserts / writeTime / 1e6);
+
+        for(size_t s = 0; s < _fillSteps; ++s) {
+            FillStep step;
+            double mops = 0.0;
+            for(auto& r: _readers) {
+                FillStep const& rs = r.steps[s];
+                step.reads += rs.reads;
+                step.found += rs.found;
+                step.histogram.merge(rs.histogram);
+                if(rs.ticks) mops += rs.reads / (rs.ticks / perNs / 1e3);
+            }
+            if(!step.reads) continue;
+            size_t fill = 100 * (s + 1) / _fillSteps;
+
+            printHeader();
+            std::cout << std::fixed << std::setw( 25 ) << _impl.name()
+                      << std::fixed << std::setw(  4 ) << _writers
+                      << std::fixed << std::setw(  4 ) << _readers.size()
+                      << std::fixed << std::setw(  9 ) << std::setprecision(2) << _writers * _inserts / writeTime / 1e6
+                      << std::fixed << std::setw(  6 ) << fill
+                      << std::fixed << std::setw( 11 ) << step.reads
+                      << std::fixed << std::setw(  9 ) << std::setprecision(2) << mops
+                      << std::fixed << std::setw(  7 ) << std::setprecision(1) << 100.0 * step.found / step.reads
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << step.histogram.percentile(0.50) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << step.histogram.percentile(0.99) / perNs
+                      << std::fixed << std::setw(  9 ) << std::setprecision(0) << step.histogram.percentile(0.999) / perNs
+                      << std::fixed << std::setw( 11 ) << std::setprecision(0) << step.histogram.max() / perNs
+                      << std::endl;
+
+            std::string name = "read_fill_" + std::to_string(fill);
+            results.set("mops." + name, mops);
+            results.set("hitratio_fill_" + std::to_string(fill), (double)step.found / step.reads);
+            recordLatency("lat." + name, step.histogram);
+        }
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "wr"
+                  << std::fixed << std::setw(  4 ) << "rd"
+                  << std::fixed << std::setw(  9 ) << "insMops"
+                  << std::fixed << std::setw(  6 ) << "fill%"
+                  << std::fixed << std::setw( 11 ) << "reads"
+                  << std::fixed << std::setw(  9 ) << "rdMops"
+                  << std::fixed << std::setw(  7 ) << "found%"
+                  << std::fixed << std::setw(  9 ) << "p50ns"
+                  << std::fixed << std::setw(  9 ) << "p99ns"
+                  << std::fixed << std::setw(  9 ) << "p99.9ns"
+                  << std::fixed << std::setw( 11 ) << "maxns"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    // Writers publish their progress every PUBLISH inserts
+    static constexpr size_t PUBLISH = 256;
+
+    void write(size_t tid) {
+        std::atomic<size_t>& inserted = _progress[tid].inserted;
+        for(size_t i = 0; i < _inserts; ++i) {
+            auto const& k = _test.key(tid, i);
+            _impl.insert(k, _test.value(tid, i, k));
+            if((i + 1) % PUBLISH == 0 || i + 1 == _inserts) {
+                size_t published = inserted.load(std::memory_order_relaxed);
+                inserted.store(i + 1, std::memory_order_release);
+                _filled.fetch_add(i + 1 - published, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Looks up keys until the last writer is done. Every read is accounted
+     * to the fill step the table was in when it started.
+     */
+    void read(size_t tid, ReaderStats& stats) {
+        Random rng(Random::seedFor(_seed, tid));
+        typename TEST::value_type v;
+        size_t total = _writers * _inserts;
+        size_t readers = _readers.size();
+        size_t countdown = _sample;
+        size_t current = 0;
+        uint64_t stepStart = __rdtsc();
+        unsigned aux;
+
+        while(_writersLeft.load(std::memory_order_acquire)) {
+            size_t step = std::min(_fillSteps - 1, _filled.load(std::memory_order_relaxed) * _fillSteps / total);
+            if(step != current) {
+                uint64_t now = __rdtsc();
+                stats.steps[current].ticks += now - stepStart;
+                stepStart = now;
+                current = step;
+            }
+            FillStep& s = stats.steps[current];
+
+            size_t rtid;
+            size_t i;
+            if(rng.nextDouble() < _hitRatio) {
+                rtid = rng.nextBelow(_writers);
+                size_t inserted = _progress[rtid].inserted.load(std::memory_order_acquire);
+                if(!inserted) continue;
+                i = rng.nextBelow(inserted);
+            } else {
+                rtid = _writers + rng.nextBelow(readers);
+                i = rng.nextBelow(_inserts);
+            }
+
+            if(--countdown) {
+                s.found += _impl.get(_test.key(rtid, i), v);
+            } else {
+                countdown = _sample;
+                uint64_t start = __rdtscp(&aux);
+                s.found += _impl.get(_test.key(rtid, i), v);
+                s.histogram.record(__rdtscp(&aux) - start);
+            }
+            s.reads++;
+        }
+        stats.steps[current].ticks += __rdtsc() - stepStart;
+    }
+
+private:
+    TEST& _test;
+    IMPL& _impl;
+    std::vector<WriterProgress> _progress;
+    std::vector<ReaderStats> _readers;
+    alignas(64) std::atomic<size_t> _filled;
+    alignas(64) std::atomic<size_t> _writersLeft;
+    size_t _bucketScale;
+    size_t _threads;
+    size_t _inserts;
+    size_t _writers;
+    size_t _fillSteps;
+    size_t _sample;
+    double _hitRatio;
+    uint64_t _seed;
+};
@@ -0,0 +1,372 @@
+#pragma once
+
+// Machine-readable results and baseline comparison.
+//
+//   --results=file.csv|file.json  write one record per run: the settings, the
+//                                 table, and every metric the drivers and
+//                                 wrappers reported (phases, latencies,
+//                                 counters, latency histograms in JSON)
+//   --repeat=n                    run every table n times
+//   --baseline=file.csv           compare against earlier results
+//
+// Metrics are named by kind: time.* (seconds) and lat.* (nanoseconds) are
+// better when lower, mops.* (million operations per second) when higher. The
+// comparison only pools and compares runs of the same table with the same
+// recorded settings, and flags a metric when the 95% confidence intervals of
+// the baseline and the current mean (Student t) do not overlap, the change is
+// for the worse and larger than --tolerance (default 0.02, relative). httest
+// then exits with status 2. A metric with fewer than 2 runs on either side
+// has no interval; it is printed, marked "n<2, not tested", and never counts
+// as a regression.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "driver.h"
+
+class Results {
+public:
+
+    struct Field {
+        std::string key;
+        std::string value;
+        bool numeric;
+        bool json;      // value is a JSON fragment, only written to JSON output
+    };
+
+    using Record = std::vector<Field>;
+
+    static Results& get() {
+        static Results results;
+        return results;
+    }
+
+    bool enabled() const {
+        return !_path.empty() || !_baselinePath.empty();
+    }
+
+    void configure() {
+        Settings& settings = Settings::global();
+        _path = settings["results"].asString();
+        _baselinePath = settings["baseline"].asString();
+    }
+
+    /**
+     * Starts the record of a run of the given table and fills in the settings.
+     */
+    void begin(std::string const& table, size_t repetition) {
+        _records.emplace_back();
+        set("table", table);
+        set("repetition", repetition);
+        Settings& settings = Settings::global();
+        for(char const* key: recordedSettings()) {
+            std::string value = settings[key].asString();
+            if(value.empty()) continue;
+            char* end;
+            strtod(value.c_str(), &end);
+            put(Field{key, value, !*end, false});
+        }
+    }
+
+    void set(std::string const& key, std::string const& value) {
+        put(Field{key, value, false, false});
+    }
+
+    void set(std::string const& key, double value) {
+        std::stringstream s;
+        s << std::setprecision(9) << value;
+        put(Field{key, s.str(), true, false});
+    }
+
+    void set(std::string const& key, size_t value) {
+        put(Field{key, std::to_string(value), true, false});
+    }
+
+    void setJson(std::string const& key, std::string const& json) {
+        put(Field{key, json, false, true});
+    }
+
+    /**
+     * Turns a phase label like "run get" into a part of a metric name.
+     */
+    static std::string metricName(std::string s) {
+        std::replace(s.begin(), s.end(), ' ', '_');
+        std::replace(s.begin(), s.end(), '.', '_');
+        return s;
+    }
+
+    /**
+     * Writes all records to --results, as JSON if the file name ends in
+     * .json, as CSV otherwise.
+     */
+    void write() const {
+        if(_path.empty()) return;
+        std::ofstream out(_path);
+        if(!out) {
+            std::cerr << "Results: cannot write " << _path << std::endl;
+            return;
+        }
+        if(_path.size() >= 5 && _path.compare(_path.size() - 5, 5, ".json") == 0) {
+            writeJson(out);
+        } else {
+            writeCsv(out, _records);
+        }
+    }
+
+    /**
+     * Compares the records of this run against --baseline. Returns the number
+     * of regressions.
+     */
+    size_t compare() const {
+        if(_baselinePath.empty()) return 0;
+        std::ifstream in(_baselinePath);
+        if(!in) {
+            std::cerr << "Results: cannot read baseline " << _baselinePath << std::endl;
+            return 0;
+        }
+        double tolerance = settingAsDouble("tolerance", 0.02);
+        auto baseline = group(readCsv(in));
+        auto current = group(_records);
+        size_t regressions = 0;
+
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 40 ) << "metric"
+                  << std::fixed << std::setw( 14 ) << "baseline"
+                  << std::fixed << std::setw( 11 ) << "+-"
+                  << std::fixed << std::setw( 14 ) << "current"
+                  << std::fixed << std::setw( 11 ) << "+-"
+                  << std::fixed << std::setw(  9 ) << "change"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+        for(auto& run: current) {
+            auto b = baseline.find(run.first);
+            if(b == baseline.end()) {
+                std::cout << run.first << ": no baseline with these settings" << std::endl;
+                continue;
+            }
+            std::cout << run.first << std::endl;
+            for(auto& metric: run.second) {
+                int direction = directionOf(metric.first);
+                auto bm = b->second.find(metric.first);
+                if(!direction || bm == b->second.end()) continue;
+                Summary cur = summarize(metric.second);
+                Summary base = summarize(bm->second);
+                double change = base.mean != 0.0 ? (cur.mean - base.mean) / base.mean : 0.0;
+                bool tested = cur.n >= 2 && base.n >= 2;
+                bool significant = tested && std::fabs(cur.mean - base.mean) > cur.halfWidth + base.halfWidth;
+                bool regression = significant && change * direction < -tolerance;
+                bool improvement = significant && change * direction > tolerance;
+                regressions += regression;
+                std::cout << (regression ? "\033[1;31m" : improvement ? "\033[1;32m" : "")
+                          << std::fixed << std::setw( 40 ) << metric.first
+                          << std::fixed << std::setw( 14 ) << std::setprecision(4) << base.mean
+                          << std::fixed << std::setw( 11 ) << std::setprecision(4) << base.halfWidth
+                          << std::fixed << std::setw( 14 ) << std::setprecision(4) << cur.mean
+                          << std::fixed << std::setw( 11 ) << std::setprecision(4) << cur.halfWidth
+                          << std::fixed << std::setw(  8 ) << std::setprecision(1) << change * 100.0 << "%"
+                          << (regression ? "  REGRESSION" : improvement ? "  improved" : !tested ? "  n<2, not tested" : "")
+                          << "\033[0m"
+                          << std::endl;
+            }
+        }
+        std::cout << regressions << " significant regression(s)" << std::endl;
+        return regressions;
+    }
+
+private:
+
+    struct Summary {
+        size_t n;
+        double mean;
+        double halfWidth;   // of the 95% confidence interval, 0 if n < 2
+    };
+
+    using Groups = std::map<std::string, std::map<std::string, std::vector<double>>>;
+
+    Results() {
+    }
+
+    static std::vector<char const*> const& recordedSettings() {
+        static std::vector<char const*> keys = {
+            "mode", "test", "threads", "inserts", "buckets_scale", "page_size_scale", "page_mode",
+            "prefault", "populate", "duplicateratio", "collisionratio", "workload", "distribution",
+            "theta", "load", "operations", "seed", "skew", "keys", "rate", "rates", "hit_ratio",
+            "hit_ratios", "contended_keys", "writers", "read_hits", "fill_steps", "pin", "cpus",
+            "latency", "latency_sample", "perf", "memory", "trace", "words", "tables", "max_probes",
+            "stash", "shard_scales", "grow_load", "initial_scale", "segment_scale",
+        };
+        return keys;
+    }
+
+    void put(Field const& field) {
+        if(_records.empty()) return;
+        Record& record = _records.back();
+        for(auto& f: record) {
+            if(f.key == field.key) {
+                f = field;
+                return;
+            }
+        }
+        record.push_back(field);
+    }
+
+    static int directionOf(std::string const& key) {
+        if(key.compare(0, 5, "mops.") == 0) return 1;
+        if(key.compare(0, 5, "time.") == 0 || key.compare(0, 4, "lat.") == 0) return -1;
+        return 0;
+    }
+
+    static std::string valueOf(Record const& record, std::string const& key) {
+        for(auto& f: record) {
+            if(f.key == key) return f.value;
+        }
+        return "";
+    }
+
+    static Groups group(std::vector<Record> const& records) {
+        Groups groups;
+        for(auto& record: records) {
+            std::string run = valueOf(record, "table");
+            for(char const* key: recordedSettings()) {
+                std::string value = valueOf(record, key);
+                if(!value.empty()) run += std::string(" ") + key + "=" + value;
+            }
+            for(auto& f: record) {
+                if(directionOf(f.key) && !f.value.empty()) {
+                    groups[run][f.key].push_back(std::stod(f.value));
+                }
+            }
+        }
+        return groups;
+    }
+
+    static Summary summarize(std::vector<double> const& values) {
+        size_t n = values.size();
+        double mean = 0.0;
+        for(double v: values) mean += v;
+        mean /= n;
+        if(n < 2) return Summary{n, mean, 0.0};
+        double var = 0.0;
+        for(double v: values) var += (v - mean) * (v - mean);
+        var /= n - 1;
+        return Summary{n, mean, studentT95(n - 1) * std::sqrt(var / n)};
+    }
+
+    /**
+     * Two-sided 95% quantile of Student's t distribution.
+     */
+    static double studentT95(size_t df) {
+        static double const t[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        return df < sizeof(t) / sizeof(t[0]) ? t[df] : 1.960;
+    }
+
+    static std::string quoteCsv(std::string const& s) {
+        if(s.find_first_of(",\"\n") == std::string::npos) return s;
+        std::string q = "\"";
+        for(char c: s) {
+            if(c == '"') q += '"';
+            q += c;
+        }
+        return q + "\"";
+    }
+
+    static std::string quoteJson(std::string const& s) {
+        std::string q = "\"";
+        for(char c: s) {
+            if(c == '"' || c == '\\') q += '\\';
+            q += c;
+        }
+        return q + "\"";
+    }
+
+    static void writeCsv(std::ostream& out, std::vector<Record> const& records) {
+        std::vector<std::string> columns;
+        for(auto& record: records) {
+            for(auto& f: record) {
+                if(!f.json && std::find(columns.begin(), columns.end(), f.key) == columns.end()) columns.push_back(f.key);
+            }
+        }
+        for(size_t c = 0; c < columns.size(); ++c) {
+            out << (c ? "," : "") << quoteCsv(columns[c]);
+        }
+        out << "\n";
+        for(auto& record: records) {
+            for(size_t c = 0; c < columns.size(); ++c) {
+                out << (c ? "," : "") << quoteCsv(valueOf(record, columns[c]));
+            }
+            out << "\n";
+        }
+    }
+
+    void writeJson(std::ostream& out) const {
+        out << "[\n";
+        for(size_t r = 0; r < _records.size(); ++r) {
+            out << "  {";
+            for(size_t i = 0; i < _records[r].size(); ++i) {
+                Field const& f = _records[r][i];
+                out << (i ? ", " : "") << quoteJson(f.key) << ": " << (f.numeric || f.json ? f.value : quoteJson(f.value));
+            }
+            out << "}" << (r + 1 < _records.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+
+    static std::vector<std::string> splitCsv(std::string const& line) {
+        std::vector<std::string> fields(1);
+        bool quoted = false;
+        for(size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if(quoted) {
+                if(c == '"' && i + 1 < line.size() && line[i+1] == '"') {
+                    fields.back() += '"';
+                    ++i;
+                } else if(c == '"') {
+                    quoted = false;
+                } else {
+                    fields.back() += c;
+                }
+            } else if(c == '"') {
+                quoted = true;
+            } else if(c == ',') {
+                fields.emplace_back();
+            } else {
+                fields.back() += c;
+            }
+        }
+        return fields;
+    }
+
+    static std::vector<Record> readCsv(std::istream& in) {
+        std::vector<Record> records;
+        std::string line;
+        if(!std::getline(in, line)) return records;
+        std::vector<std::string> columns = splitCsv(line);
+        while(std::getline(in, line)) {
+            if(line.empty()) continue;
+            std::vector<std::string> values = splitCsv(line);
+            Record record;
+            for(size_t c = 0; c < columns.size() && c < values.size(); ++c) {
+                if(!values[c].empty()) record.push_back(Field{columns[c], values[c], false, false});
+            }
+            records.push_back(std::move(record));
+        }
+        return records;
+    }
+
+private:
+    std::string _path;
+    std::string _baselinePath;
+    std::vector<Record> _records;
+};
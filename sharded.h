@@ -0,0 +1,219 @@
+#pragma once
+
+// Sharded<HT, SHARDS>: SHARDS independent tables of type HT behind the usual
+// insert/get interface. A key goes to the shard given by the top bits of its
+// MurmurHash64, multiplied by a Fibonacci constant first so that the shard
+// does not correlate with the bits the tables use for their buckets and tags.
+//
+// Every shard is sized on its own and has its own tables, so its own slab
+// manager and bucket array. A shard grows on its own as well: once HT reports
+// FULL (see probing.h), the shard adds a generation, a table twice the size
+// of its newest one. Inserts try the generations from the oldest to the
+// newest and stop at the first that does not report FULL; slots never empty
+// again, so a key can only end up in one of them. Lookups try the newest one
+// first. Nothing is migrated, so growth costs one table allocation of one
+// shard, and the other shards and the readers of this one never wait for it.
+// Tables without tryInsert() never report FULL and keep their first size.
+//
+// Growth wants a small --max_probes, 64 say: with the default, a table only
+// reports FULL once every slot is taken, and from then on every operation
+// that reaches that generation probes all of it.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <numa.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "murmurhash.h"
+#include "probing.h"
+
+namespace hashtables {
+
+template<typename HT, size_t SHARDS>
+class Sharded {
+public:
+
+    static_assert(SHARDS > 0 && (SHARDS & (SHARDS - 1)) == 0, "SHARDS must be a power of two");
+
+    static constexpr size_t MAX_GENERATIONS = 16;
+
+    /**
+     * Shard s gets 2^scales[s] buckets and its tables prefer NUMA node
+     * nodes[s] (-1 for none). Missing entries mean 2^(bucketsScale -
+     * log2(SHARDS)) buckets and no preference.
+     */
+    Sharded(size_t bucketsScale, std::vector<size_t> const& scales = {}, std::vector<int> const& nodes = {})
+    {
+        size_t defaultScale = bucketsScale > shardBits() + 1 ? bucketsScale - shardBits() : 1;
+        for(size_t s = 0; s < SHARDS; ++s) {
+            Shard& shard = _shards[s];
+            shard.firstScale = s < scales.size() ? scales[s] : defaultScale;
+            shard.node = s < nodes.size() ? nodes[s] : -1;
+            for(auto& g: shard.tables) g.store(nullptr, std::memory_order_relaxed);
+            shard.fullInserts.store(0, std::memory_order_relaxed);
+            shard.tables[0].store(createTable(shard, 0), std::memory_order_relaxed);
+            shard.generations.store(1, std::memory_order_release);
+        }
+    }
+
+    Sharded(Sharded const&) = delete;
+    Sharded& operator=(Sharded const&) = delete;
+
+    ~Sharded() {
+        for(Shard& shard: _shards) {
+            for(auto& g: shard.tables) {
+                delete g.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static constexpr size_t shards() {
+        return SHARDS;
+    }
+
+    template<typename K>
+    __attribute__((always_inline))
+    size_t shardOf(K const& key) const {
+        return (MurmurHash64(key) * 0x9E3779B97F4A7C15ULL) >> (63 - shardBits()) >> 1;
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    V insert(K const& key, V const& value) {
+        V result;
+        tryInsert(key, value, result);
+        return result;
+    }
+
+    /**
+     * As HT::tryInsert(), growing the shard of key when its newest table is
+     * full. Reports FULL only when the shard has MAX_GENERATIONS tables and
+     * all are full.
+     */
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    InsertResult tryInsert(K const& key, V const& value, V& result) {
+        return tryInsert(_shards[shardOf(key)], key, value, result, has_try_insert<HT, K, V>{});
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    bool get(K const& key, V& value) {
+        Shard& shard = _shards[shardOf(key)];
+        size_t g = shard.generations.load(std::memory_order_acquire);
+        while(g--) {
+            if(shard.tables[g].load(std::memory_order_relaxed)->get(key, value)) return true;
+        }
+        return false;
+    }
+
+    void thread_init() {
+        for(Shard& shard: _shards) {
+            size_t generations = shard.generations.load(std::memory_order_acquire);
+            for(size_t g = 0; g < generations; ++g) {
+                shard.tables[g].load(std::memory_order_relaxed)->thread_init();
+            }
+        }
+    }
+
+    struct ShardStats {
+        size_t generations;     // tables of the shard
+        size_t bucketsScale;    // scale of its newest table
+        size_t fullInserts;     // inserts that found all MAX_GENERATIONS tables full
+    };
+
+    ShardStats shardStats(size_t s) const {
+        Shard const& shard = _shards[s];
+        size_t generations = shard.generations.load(std::memory_order_acquire);
+        return ShardStats{generations, shard.firstScale + generations - 1, shard.fullInserts.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * Calls f(table) for every table of shard s, the oldest first. Must not
+     * run concurrently with inserts.
+     */
+    template<typename F>
+    void forEachTable(size_t s, F&& f) {
+        Shard& shard = _shards[s];
+        size_t generations = shard.generations.load(std::memory_order_acquire);
+        for(size_t g = 0; g < generations; ++g) {
+            f(*shard.tables[g].load(std::memory_order_relaxed));
+        }
+    }
+
+private:
+
+    // Padded rather than aligned: the wrapper is allocated with new, which
+    // does not honour extended alignment before C++17
+    struct Shard {
+        std::atomic<size_t> generations;
+        std::atomic<HT*> tables[MAX_GENERATIONS];
+        std::atomic<size_t> fullInserts;
+        size_t firstScale;
+        int node;
+        std::mutex growLock;
+        char padding[64];
+    };
+
+    static constexpr size_t shardBits() {
+        return __builtin_ctzll(SHARDS);
+    }
+
+    template<typename K, typename V>
+    InsertResult tryInsert(Shard& shard, K const& key, V const& value, V& result, std::true_type) {
+        size_t generations = shard.generations.load(std::memory_order_acquire);
+        for(size_t g = 0;; ++g) {
+            if(g == generations) {
+                generations = grow(shard, generations);
+                if(g == generations) {
+                    shard.fullInserts.fetch_add(1, std::memory_order_relaxed);
+                    result = value;
+                    return InsertResult::FULL;
+                }
+            }
+            InsertResult r = shard.tables[g].load(std::memory_order_relaxed)->tryInsert(key, value, result);
+            if(r != InsertResult::FULL) return r;
+        }
+    }
+
+    template<typename K, typename V>
+    InsertResult tryInsert(Shard& shard, K const& key, V const& value, V& result, std::false_type) {
+        result = shard.tables[0].load(std::memory_order_relaxed)->insert(key, value);
+        return InsertResult::INSERTED;
+    }
+
+    /**
+     * Adds a generation to shard unless another thread already did since the
+     * caller saw the given number of them. Returns the number of generations.
+     */
+    __attribute__((noinline))
+    size_t grow(Shard& shard, size_t seen) {
+        std::lock_guard<std::mutex> lock(shard.growLock);
+        size_t generations = shard.generations.load(std::memory_order_acquire);
+        if(generations != seen || generations == MAX_GENERATIONS) return generations;
+        shard.tables[generations].store(createTable(shard, generations), std::memory_order_relaxed);
+        shard.generations.store(generations + 1, std::memory_order_release);
+        return generations + 1;
+    }
+
+    /**
+     * Pages that the constructor faults in (--prefault, --populate) come
+     * from the node of the shard; the rest are placed on first touch.
+     */
+    static HT* createTable(Shard& shard, size_t generation) {
+        bool place = shard.node >= 0 && numa_available() >= 0;
+        if(place) numa_set_preferred(shard.node);
+        HT* table = new HT(shard.firstScale + generation);
+        if(place) numa_set_localalloc();
+        return table;
+    }
+
+private:
+    Shard _shards[SHARDS];
+};
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+// The default driver, --mode=simple: every thread inserts its --inserts keys,
+// then every thread looks its keys up again. Prints one row under the header
+// of main() with the times in seconds of setting up the test data and the
+// table, of inserting and verifying (wall clock, and summed over the
+// threads), of the cleanup and in total, and records them in the --results.
+// With --stats=1 the statistics of the table are printed before cleanup.
+//
+// Replaces SimpleTest of tests/common.h, which only printed its numbers.
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "common/timer.h"
+#include "driver.h"
+#include "results.h"
+
+template<typename TEST, typename IMPL>
+class SimpleDriver {
+public:
+
+    SimpleDriver(TEST& test, IMPL& impl)
+    : _test(test)
+    , _impl(impl)
+    {
+    }
+
+    void test() {
+        Settings& settings = Settings::global();
+        size_t bucketScale = settings["buckets_scale"].asUnsignedValue();
+        size_t pageSizeScale = settings["page_size_scale"].asUnsignedValue();
+        size_t threads = settings["threads"].asUnsignedValue();
+        size_t inserts = settings["inserts"].asUnsignedValue();
+
+        Timer total;
+        Timer timer;
+        _test.setup(bucketScale, threads, inserts, settingAsDouble("duplicateratio", 0.0), settingAsDouble("collisionratio", 1.0));
+        _impl.init(bucketScale);
+        double setupTime = timer.getElapsedSeconds();
+
+        auto threadInit = [this](size_t tid) {
+            _impl.thread_init(tid);
+        };
+
+        std::vector<double> threadTimes(threads * STRIDE);
+        double insertTime = runThreads(threads, threadInit, [this, inserts, &threadTimes](size_t tid) {
+            Timer timer;
+            for(size_t i = 0; i < inserts; ++i) {
+                auto const& k = _test.key(tid, i);
+                _impl.insert(k, _test.value(tid, i, k));
+            }
+            threadTimes[tid * STRIDE] = timer.getElapsedSeconds();
+        });
+        double insertSum = sum(threadTimes, threads);
+
+        std::vector<size_t> found(threads * STRIDE);
+        double verifyTime = runThreads(threads, threadInit, [this, inserts, &threadTimes, &found](size_t tid) {
+            Timer timer;
+            size_t hits = 0;
+            for(size_t i = 0; i < inserts; ++i) {
+                typename TEST::value_type v;
+                hits += _impl.get(_test.key(tid, i), v);
+            }
+            found[tid * STRIDE] = hits;
+            threadTimes[tid * STRIDE] = timer.getElapsedSeconds();
+        });
+        double verifySum = sum(threadTimes, threads);
+
+        if(settings["stats"].asUnsignedValue()) {
+            _impl.statsString(std::cout, settings["bars"].asUnsignedValue());
+        }
+
+        timer.reset();
+        _impl.cleanup();
+        double cleanTime = timer.getElapsedSeconds();
+        double totalTime = total.getElapsedSeconds();
+
+        size_t ops = inserts * threads;
+        size_t hits = 0;
+        for(size_t tid = 0; tid < threads; ++tid) {
+            hits += found[tid * STRIDE];
+        }
+
+        std::cout << std::fixed << std::setw( 25 ) << _impl.name()
+                  << std::fixed << std::setw(  4 ) << bucketScale
+                  << std::fixed << std::setw(  4 ) << pageSizeScale
+                  << std::fixed << std::setw(  4 ) << threads
+                  << std::fixed << std::setw(  9 ) << inserts
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << setupTime
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << insertTime
+                  << std::fixed << std::setw(  8 ) << std::setprecision(3) << insertSum
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << verifyTime
+                  << std::fixed << std::setw(  8 ) << std::setprecision(3) << verifySum
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << cleanTime
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << totalTime
+                  << std::endl;
+        if(hits != ops) {
+            std::cout << "verify: " << ops - hits << " of " << ops << " keys not found" << std::endl;
+        }
+
+        Results& results = Results::get();
+        results.set("time.setup", setupTime);
+        results.set("time.insert", insertTime);
+        results.set("inssum", insertSum);
+        results.set("time.verify", verifyTime);
+        results.set("vfysum", verifySum);
+        results.set("time.clean", cleanTime);
+        results.set("time.total", totalTime);
+        if(insertTime > 0.0) results.set("mops.insert", ops / insertTime / 1e6);
+        if(verifyTime > 0.0) results.set("mops.verify", ops / verifyTime / 1e6);
+        results.set("hitratio_verify", ops ? (double)hits / ops : 0.0);
+    }
+
+private:
+
+    // Keeps the per-thread results on separate cache lines
+    static constexpr size_t STRIDE = 64 / sizeof(double);
+
+    template<typename T>
+    static double sum(std::vector<T> const& perThread, size_t threads) {
+        double s = 0.0;
+        for(size_t tid = 0; tid < threads; ++tid) {
+            s += perThread[tid * STRIDE];
+        }
+        return s;
+    }
+
+private:
+    TEST& _test;
+    IMPL& _impl;
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+// Many-tables benchmark, selected with --mode=tables.
+//
+// Creates --tables=32 (the default) tables of the selected kind, each with
+// 2^(buckets_scale - ceil(log2(tables))) buckets, so together they have
+// about as many buckets as one table of the other modes. Every thread
+// inserts its keys round-robin into all tables and then looks them up again,
+// so every thread keeps allocating for all tables at once. The row shows both
+// phases, the keys that were found again and the slabs the tables mapped.
+//
+// The implementation is copied once per table, so this runs on the plain
+// implementation: --latency, --memory, --perf, --record and --pin do not
+// apply.
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "allocator.h"
+#include "driver.h"
+#include "results.h"
+
+template<typename TEST, typename IMPL, bool COPYABLE = std::is_copy_constructible<IMPL>::value>
+class TablesTest {
+public:
+
+    TablesTest(TEST& test, IMPL& impl)
+    : _test(test)
+    , _impl(impl)
+    {
+    }
+
+    void test() {
+        Settings& settings = Settings::global();
+        size_t bucketScale = settings["buckets_scale"].asUnsignedValue();
+        size_t threads = settings["threads"].asUnsignedValue();
+        size_t inserts = settings["inserts"].asUnsignedValue();
+        size_t tables = std::max<size_t>(1, settingAsUnsigned("tables", 32));
+        size_t tableScale = bucketScale;
+        for(size_t t = 1; t < tables && tableScale > 1; t <<= 1) tableScale--;
+        _test.setup(bucketScale, threads, inserts, settingAsDouble("duplicateratio", 0.0), settingAsDouble("collisionratio", 1.0));
+
+        SlabManager::Usage before = SlabManager::totalUsage();
+        _tables.assign(tables, _impl);
+        for(IMPL& table: _tables) {
+            table.init(tableScale);
+        }
+        auto threadInit = [this](size_t tid) {
+            for(IMPL& table: _tables) {
+                table.thread_init(tid);
+            }
+        };
+
+        double insertTime = runThreads(threads, threadInit, [this, inserts](size_t tid) {
+            insert(tid, inserts);
+        });
+        SlabManager::Usage after = SlabManager::totalUsage();
+
+        std::vector<size_t> found(threads * FOUND_STRIDE);
+        double lookupTime = runThreads(threads, threadInit, [this, inserts, &found](size_t tid) {
+            found[tid * FOUND_STRIDE] = lookup(tid, inserts);
+        });
+
+        for(IMPL& table: _tables) {
+            table.cleanup();
+        }
+        _tables.clear();
+
+        size_t ops = inserts * threads;
+        size_t hits = 0;
+        for(size_t tid = 0; tid < threads; ++tid) {
+            hits += found[tid * FOUND_STRIDE];
+        }
+        size_t slabs = after.slabs - before.slabs;
+        double reservedMB = (after.reserved - before.reserved) / 1048576.0;
+        double usedMB = (after.used - before.used) / 1048576.0;
+
+        printHeader();
+        std::cout << std::fixed << std::setw( 25 ) << _impl.name()
+                  << std::fixed << std::setw(  4 ) << tableScale
+                  << std::fixed << std::setw(  4 ) << threads
+                  << std::fixed << std::setw(  7 ) << tables
+                  << std::fixed << std::setw( 11 ) << ops
+                  << std::fixed << std::setw(  8 ) << std::setprecision(3) << insertTime
+                  << std::fixed << std::setw(  8 ) << std::setprecision(2) << ops / insertTime / 1e6
+                  << std::fixed << std::setw(  8 ) << std::setprecision(3) << lookupTime
+                  << std::fixed << std::setw(  8 ) << std::setprecision(2) << ops / lookupTime / 1e6
+                  << std::fixed << std::setw(  7 ) << std::setprecision(1) << 100.0 * hits / ops
+                  << std::fixed << std::setw(  7 ) << slabs
+                  << std::fixed << std::setw( 10 ) << std::setprecision(1) << reservedMB
+                  << std::fixed << std::setw(  9 ) << std::setprecision(1) << usedMB
+                  << std::endl;
+
+        Results& results = Results::get();
+        results.set("time.tables_insert", insertTime);
+        results.set("mops.tables_insert", ops / insertTime / 1e6);
+        results.set("time.tables_lookup", lookupTime);
+        results.set("mops.tables_lookup", ops / lookupTime / 1e6);
+        results.set("hitratio_tables", (double)hits / ops);
+        results.set("slab.tables.slabs", slabs);
+        results.set("slab.tables.reserved", after.reserved - before.reserved);
+        results.set("slab.tables.used", after.used - before.used);
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "scl"
+                  << std::fixed << std::setw(  4 ) << "ths"
+                  << std::fixed << std::setw(  7 ) << "tables"
+                  << std::fixed << std::setw( 11 ) << "inserts"
+                  << std::fixed << std::setw(  8 ) << "ins"
+                  << std::fixed << std::setw(  8 ) << "Mops"
+                  << std::fixed << std::setw(  8 ) << "get"
+                  << std::fixed << std::setw(  8 ) << "Mops"
+                  << std::fixed << std::setw(  7 ) << "found%"
+                  << std::fixed << std::setw(  7 ) << "slabs"
+                  << std::fixed << std::setw( 10 ) << "slabMB"
+                  << std::fixed << std::setw(  9 ) << "usedMB"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    // Keeps the per-thread hit counters on separate cache lines
+    static constexpr size_t FOUND_STRIDE = 64 / sizeof(size_t);
+
+    __attribute__((always_inline))
+    IMPL& tableOf(size_t tid, size_t i, size_t inserts) {
+        return _tables[(tid * inserts + i) % _tables.size()];
+    }
+
+    void insert(size_t tid, size_t inserts) {
+        for(size_t i = 0; i < inserts; ++i) {
+            auto const& k = _test.key(tid, i);
+            tableOf(tid, i, inserts).insert(k, _test.value(tid, i, k));
+        }
+    }
+
+    size_t lookup(size_t tid, size_t inserts) {
+        size_t hits = 0;
+        for(size_t i = 0; i < inserts; ++i) {
+            typename TEST::value_type v;
+            hits += tableOf(tid, i, inserts).get(_test.key(tid, i), v);
+        }
+        return hits;
+    }
+
+private:
+    TEST& _test;
+    IMPL& _impl;
+    std::vector<IMPL> _tables;
+};
+
+template<typename TEST, typename IMPL>
+class TablesTest<TEST, IMPL, false> {
+public:
+
+    TablesTest(TEST& test, IMPL& impl)
+    : _impl(impl)
+    {
+    }
+
+    void test() {
+        std::cerr << "--mode=tables needs a copyable implementation, " << _impl.name() << " is not" << std::endl;
+    }
+
+private:
+    IMPL& _impl;
+};
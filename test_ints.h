@@ -1,5 +1,7 @@
 #pragma once
 
+#include "topology.h"
+
 namespace TestInts {
 
 struct TestData {
@@ -20,6 +22,7 @@ struct TestData {
         for(size_t i = _threads*_inserts; i--;) {
             _randomInts1.push_back((1 + rand()) & 0xFFFFFFFFFFFFULL);
         }
+        Topology::get().placeThreadData(_randomInts1.data(), _inserts * sizeof(size_t), _threads);
     }
 
     ~TestData() {
@@ -0,0 +1,140 @@
+#pragma once
+
+// Skewed integer keys, selected with -T z. Threads draw their keys from a
+// universe of --keys distinct 48-bit keys (default threads*inserts) with
+//   --skew=zipf     Zipf(--theta) over the universe (default, theta 0.99)
+//   --skew=hotspot  --hot_ops of the draws go to the first --hot_keys
+//                   fraction of the universe, the rest is uniform
+//   --skew=latest   Zipf over the distance to the key the stream would insert
+//                   at that point in time, so recently inserted keys are hot
+// Hot keys are drawn by all threads, so they are inserted concurrently and
+// repeatedly. The streams are generated once per configuration, in parallel,
+// and only depend on --seed.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "driver.h"
+#include "topology.h"
+
+namespace TestSkewed {
+
+struct TestData {
+    size_t _inserts;
+    size_t _threads;
+    std::string _description;
+    std::vector<size_t> _keys;
+
+    TestData(size_t inserts, size_t threads, std::string const& description)
+    : _inserts(inserts)
+    , _threads(threads)
+    , _description(description)
+    , _keys(inserts * threads)
+    {
+        std::string skew = Settings::global()["skew"].asString();
+        size_t universe = std::max<size_t>(2, settingAsUnsigned("keys", threads * inserts));
+        uint64_t seed = settingAsUnsigned("seed", 1234567);
+        double hotKeys = settingAsDouble("hot_keys", 0.01);
+        double hotOps = settingAsDouble("hot_ops", 0.9);
+        size_t hotUniverse = std::min(universe, std::max<size_t>(1, universe * hotKeys));
+
+        ZipfianGenerator zipf(universe, settingAsDouble("theta", 0.99), threads);
+
+        std::vector<std::thread> workers;
+        for(size_t tid = 0; tid < threads; ++tid) {
+            workers.emplace_back([&, tid]() {
+                Random rng(Random::seedFor(seed, tid));
+                size_t* keys = &_keys[tid * inserts];
+                for(size_t i = 0; i < inserts; ++i) {
+                    size_t rank;
+                    if(skew == "hotspot") {
+                        rank = rng.nextDouble() < hotOps ? rng.nextBelow(hotUniverse)
+                                                         : hotUniverse + rng.nextBelow(universe - hotUniverse);
+                        if(rank >= universe) rank = rng.nextBelow(universe);
+                    } else if(skew == "latest") {
+                        size_t now = i * threads + tid;
+                        size_t back = zipf.next(rng);
+                        rank = (back <= now ? now - back : 0) % universe;
+                    } else {
+                        rank = zipf.next(rng);
+                    }
+                    keys[i] = keyOfRank(rank);
+                }
+            });
+        }
+        for(auto& w: workers) {
+            w.join();
+        }
+        Topology::get().placeThreadData(_keys.data(), inserts * sizeof(size_t), threads);
+    }
+
+    /**
+     * Bijection on [1, 2^48): ranks map to distinct, non-zero, scattered keys,
+     * so popular keys do not share buckets.
+     */
+    static size_t keyOfRank(size_t rank) {
+        const size_t mask = 0xFFFFFFFFFFFFULL;
+        size_t x = (rank + 1) & mask;
+        x ^= x >> 25;
+        x = (x * 0x9E3779B97F4BULL) & mask;
+        x ^= x >> 23;
+        x = (x * 0xBF58476D1CE5ULL) & mask;
+        x ^= x >> 27;
+        return x;
+    }
+
+    static std::vector<TestData>& getTestDataCache() {
+        static std::vector<TestData> testDataCache;
+        return testDataCache;
+    }
+
+    static std::string describeSettings() {
+        Settings& settings = Settings::global();
+        return settings["skew"].asString() + "/" + settings["keys"].asString() + "/" + settings["theta"].asString()
+             + "/" + settings["hot_keys"].asString() + "/" + settings["hot_ops"].asString() + "/" + settings["seed"].asString();
+    }
+};
+
+template<typename IMPL>
+class Test {
+public:
+
+    using key_type = size_t;
+    using value_type = size_t;
+
+    Test()
+    {
+    }
+
+    size_t const& key(size_t tid, size_t i) {
+        return testData->_keys[tid*testData->_inserts+i];
+    }
+
+    size_t value(size_t tid, size_t i, size_t const& k) {
+        return k;
+    }
+
+    bool setup(size_t bucketScale, size_t threads, size_t inserts, double duplicateRatio = 0.0, double collisionRatio = 1.0) {
+        std::string description = TestData::describeSettings();
+        for(TestData& td: TestData::getTestDataCache()) {
+            if(td._threads == threads && td._inserts == inserts && td._description == description) {
+                testData = &td;
+                return true;
+            }
+        }
+        TestData::getTestDataCache().emplace_back(inserts, threads, description);
+        auto& td = TestData::getTestDataCache().back();
+        testData = &td;
+        return true;
+    }
+
+    bool reset() {
+        return true;
+    }
+
+private:
+    TestData* testData;
+};
+
+}
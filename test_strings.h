@@ -4,6 +4,7 @@
 
 #include "murmurhash.h"
 #include "mystring.h"
+#include "topology.h"
 
 namespace TestStrings {
 
@@ -86,6 +87,7 @@ public:
         for (int i = td._stringsTotal; i--; ) {
             generateRandomString(&td._randomStrings[i], dist, rng, 32);
         }
+        Topology::get().placeThreadData(td._randomStrings, td._inserts * sizeof(my_string), td._threads);
     }
 
     my_string const& getSomeString(int tid, size_t i) {
@@ -5,6 +5,7 @@
 
 #include "murmurhash.h"
 #include "myvector.h"
+#include "topology.h"
 
 namespace TestVectors {
 
@@ -190,6 +191,7 @@ public:
                     strncpy(td._randomStrings[location].data, td._randomStrings[locationSource].data, td._randomStrings[locationSource].size);
                 }
             }
+            Topology::get().placeThreadData(td._randomStrings.data(), td._inserts * sizeof(myvector), td._threads);
 //            for(auto& t: threads) t.join();
 //            for (size_t location = 0; location < td._stringsTotal; ++location) {
 //                std::cout << location << " -> " << td._randomStrings[location] << std::endl;
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cctype>
 #include <cstring>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <random>
 
 #include "murmurhash.h"
 #include "mystring.h"
+#include "topology.h"
 
 struct WordData {
     size_t _inserts;
@@ -78,7 +86,7 @@ public:
 
     void readInWords(WordData& td) {
         std::ifstream file;
-        file.open("../../words.txt");
+        file.open(Settings::global()["words"].asString());
         std::string word;
 
         size_t wordsRead = 0;
@@ -97,6 +105,9 @@ public:
             new(&td._words[wordsRead++]) my_string(strdup(word.c_str()), word.length());
         }
         td._wordsTotal = wordsRead;
+        if(td._wordsTotal >= td._inserts * td._threads) {
+            Topology::get().placeThreadData(td._words, td._inserts * sizeof(my_string), td._threads);
+        }
         std::cout << "Read " << wordsRead << " words" << std::endl;
     }
 
@@ -136,3 +147,135 @@ public:
 private:
     WordData* testData;
 };
+
+/**
+ * The words of a text file, as my_string_ref keys pointing into a read-only
+ * mapping of the file. Only the array of references is allocated, the words
+ * themselves are neither allocated nor copied.
+ */
+struct MappedWordData {
+    size_t _inserts;
+    size_t _threads;
+    size_t _wordsTotal;
+    my_string_ref* _words;
+    const char* _map;
+    size_t _size;
+
+    MappedWordData(size_t inserts, size_t threads)
+    : _inserts(inserts)
+    , _threads(threads)
+    , _wordsTotal(0)
+    , _words(nullptr)
+    , _map(nullptr)
+    , _size(0)
+    {
+
+    }
+
+    MappedWordData(MappedWordData const&) = delete;
+    MappedWordData& operator=(MappedWordData const&) = delete;
+
+    ~MappedWordData() {
+        free(_words);
+        if(_map) munmap((void*)_map, _size);
+    }
+
+    static std::deque<MappedWordData>& getTestDataCache() {
+        static std::deque<MappedWordData> testDataCache;
+        return testDataCache;
+    }
+};
+
+template<typename IMPL>
+class TestWordsMapped {
+public:
+
+    using key_type = my_string_ref;
+    using value_type = size_t;
+
+    TestWordsMapped()
+    : testData(nullptr)
+    {
+    }
+
+    /**
+     * Maps the file and splits it at whitespace, like reading it word by word
+     * with operator>> would.
+     */
+    bool mapWords(MappedWordData& td) {
+        std::string path = Settings::global()["words"].asString();
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if(fd < 0 || fstat(fd, &st) || st.st_size == 0) {
+            std::cerr << "Could not map words from " << path << std::endl;
+            if(fd >= 0) close(fd);
+            return false;
+        }
+        td._size = st.st_size;
+        void* map = mmap(nullptr, td._size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(map == MAP_FAILED) {
+            std::cerr << "Could not map words from " << path << std::endl;
+            return false;
+        }
+        td._map = (const char*)map;
+        madvise(map, td._size, MADV_SEQUENTIAL);
+
+        size_t wordsRead = 0;
+        size_t spaceFor = 0;
+        const char* c = td._map;
+        const char* end = td._map + td._size;
+        while(c < end) {
+            while(c < end && isspace((unsigned char)*c)) c++;
+            const char* word = c;
+            while(c < end && !isspace((unsigned char)*c)) c++;
+            if(c == word) break;
+            if(wordsRead == spaceFor) {
+                spaceFor = spaceFor ? spaceFor << 1 : 1 << 16;
+                td._words = (my_string_ref*)realloc(td._words, spaceFor * sizeof(my_string_ref));
+            }
+            new(&td._words[wordsRead++]) my_string_ref(word, c - word);
+        }
+        madvise(map, td._size, MADV_NORMAL);
+        td._wordsTotal = wordsRead;
+        if(td._wordsTotal >= td._inserts * td._threads) {
+            Topology::get().placeThreadData(td._words, td._inserts * sizeof(my_string_ref), td._threads);
+        }
+        std::cout << "Mapped " << wordsRead << " words" << std::endl;
+        return wordsRead > 0;
+    }
+
+    my_string_ref const& key(size_t tid, size_t i) {
+        return testData->_words[(tid*testData->_inserts+i) % testData->_wordsTotal];
+    }
+
+    size_t value(size_t tid, size_t i, my_string_ref const& key) {
+        return (key.len);
+    }
+
+    bool setup(size_t bucketScale, size_t threads, size_t inserts, double duplicateRatio = 0.0, double collisionRatio = 1.0) {
+        assert(duplicateRatio == 0.0 && "duplicate setting not supported");
+        assert(collisionRatio == 1.0 && "collision setting not supported");
+        for(MappedWordData& td: MappedWordData::getTestDataCache()) {
+            if(td._threads == threads && td._inserts == inserts) {
+                testData = &td;
+                return true;
+            }
+        }
+        MappedWordData::getTestDataCache().emplace_back(inserts, threads);
+        auto& td = MappedWordData::getTestDataCache().back();
+        if(!mapWords(td)) {
+            // The drivers do not check setup(), so do not let them run on no keys
+            exit(EXIT_FAILURE);
+        }
+        testData = &td;
+        return true;
+    }
+
+    bool reset() {
+        return true;
+    }
+
+private:
+    MappedWordData* testData;
+};
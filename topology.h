@@ -0,0 +1,281 @@
+#pragma once
+
+// Thread placement, selected with --pin=...:
+//   none     - leave the threads to the scheduler (default)
+//   compact  - fill a socket before the next one, one thread per core first,
+//              then the SMT siblings on that socket
+//   scatter  - round robin over the sockets, one thread per core first
+//   smt      - fill a core (all its SMT siblings) before the next one
+//   list     - the CPUs given with --cpus=0,2,8-15, in that order
+// Threads beyond the number of CPUs wrap around. Only CPUs in the affinity
+// mask of the process are used, so this composes with taskset/numactl.
+//
+// While pinning, the test suites move the test data of every thread to the
+// NUMA node of the CPU it runs on, see placeThreadData().
+
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "driver.h"
+
+class Topology {
+public:
+
+    struct Cpu {
+        int cpu;
+        int core;
+        int socket;
+        int node;
+    };
+
+    static Topology& get() {
+        static Topology topology;
+        return topology;
+    }
+
+    bool pinning() const {
+        return !_order.empty();
+    }
+
+    /**
+     * The CPU thread tid runs on, or -1 when not pinning.
+     */
+    int cpuOf(size_t tid) const {
+        return _order.empty() ? -1 : _order[tid % _order.size()];
+    }
+
+    int nodeOf(size_t tid) const {
+        int cpu = cpuOf(tid);
+        if(cpu < 0) return -1;
+        for(auto& c: _cpus) {
+            if(c.cpu == cpu) return c.node;
+        }
+        return -1;
+    }
+
+    void pin(size_t tid) const {
+        int cpu = cpuOf(tid);
+        if(cpu < 0) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if(sched_setaffinity(0, sizeof(set), &set)) {
+            std::cerr << "Topology: could not pin thread " << tid << " to CPU " << cpu << std::endl;
+        }
+    }
+
+    /**
+     * Moves the pages of [base, base + threads * bytesPerThread) that lie
+     * entirely within the slice of one thread to the node of that thread.
+     * Does nothing when not pinning or on a single node.
+     */
+    void placeThreadData(void const* base, size_t bytesPerThread, size_t threads) const {
+        if(!pinning() || numa_available() < 0 || numa_num_configured_nodes() < 2) return;
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        for(size_t tid = 0; tid < threads; ++tid) {
+            size_t start = ((size_t)base + tid * bytesPerThread + pageSize - 1) & ~(pageSize - 1);
+            size_t end = ((size_t)base + (tid + 1) * bytesPerThread) & ~(pageSize - 1);
+            int node = nodeOf(tid);
+            if(start >= end || node < 0) continue;
+            unsigned long mask = 1UL << node;
+            mbind((void*)start, end - start, MPOL_PREFERRED, &mask, sizeof(mask) * 8, MPOL_MF_MOVE);
+        }
+    }
+
+    std::string describe() const {
+        std::map<int, int> sockets;
+        std::map<std::pair<int,int>, int> cores;
+        std::map<int, int> nodes;
+        for(auto& c: _cpus) {
+            sockets[c.socket]++;
+            cores[{c.socket, c.core}]++;
+            nodes[c.node]++;
+        }
+        std::stringstream s;
+        s << "topology: " << sockets.size() << " sockets, " << cores.size() << " cores, "
+          << _cpus.size() << " cpus, " << nodes.size() << " nodes; pin=" << _policy;
+        if(!_order.empty()) {
+            s << ", cpus";
+            for(size_t i = 0; i < _order.size(); ++i) {
+                s << (i ? "," : " ") << _order[i];
+            }
+        }
+        return s.str();
+    }
+
+private:
+
+    Topology() {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        bool numa = numa_available() >= 0;
+        for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if(!CPU_ISSET(cpu, &allowed)) continue;
+            std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            _cpus.push_back(Cpu{cpu, readInt(dir + "core_id", cpu), readInt(dir + "physical_package_id", 0), numa ? std::max(0, numa_node_of_cpu(cpu)) : 0});
+        }
+        std::sort(_cpus.begin(), _cpus.end(), [](Cpu const& a, Cpu const& b) {
+            return a.socket != b.socket ? a.socket < b.socket : a.core != b.core ? a.core < b.core : a.cpu < b.cpu;
+        });
+
+        Settings& settings = Settings::global();
+        _policy = settings["pin"].asString();
+        std::string cpus = settings["cpus"].asString();
+        if(_policy.empty()) _policy = cpus.empty() ? "none" : "list";
+
+        if(_policy == "compact") {
+            for(auto& socket: bySocket()) {
+                append(_order, siblingsLast(socket));
+            }
+        } else if(_policy == "scatter") {
+            std::vector<std::vector<int>> lists;
+            for(auto& socket: bySocket()) {
+                lists.push_back(siblingsLast(socket));
+            }
+            for(size_t i = 0; _order.size() < _cpus.size(); ++i) {
+                for(auto& list: lists) {
+                    if(i < list.size()) _order.push_back(list[i]);
+                }
+            }
+        } else if(_policy == "smt") {
+            for(auto& c: _cpus) {
+                _order.push_back(c.cpu);
+            }
+        } else if(_policy == "list") {
+            _order = parseCpuList(cpus);
+        } else if(_policy != "none") {
+            std::cerr << "Topology: unknown pin policy " << _policy << ", not pinning" << std::endl;
+            _policy = "none";
+        }
+    }
+
+    std::vector<std::vector<Cpu>> bySocket() const {
+        std::vector<std::vector<Cpu>> sockets;
+        for(auto& c: _cpus) {
+            if(sockets.empty() || sockets.back().front().socket != c.socket) sockets.emplace_back();
+            sockets.back().push_back(c);
+        }
+        return sockets;
+    }
+
+    /**
+     * The CPUs of one socket, first one per core, then the second SMT
+     * siblings, etc. Expects the CPUs sorted by core.
+     */
+    static std::vector<int> siblingsLast(std::vector<Cpu> const& cpus) {
+        std::vector<std::pair<size_t, int>> ranked;
+        for(size_t i = 0, rank = 0; i < cpus.size(); ++i) {
+            rank = i && cpus[i-1].core == cpus[i].core ? rank + 1 : 0;
+            ranked.emplace_back(rank, cpus[i].cpu);
+        }
+        std::stable_sort(ranked.begin(), ranked.end(), [](std::pair<size_t, int> const& a, std::pair<size_t, int> const& b) {
+            return a.first < b.first;
+        });
+        std::vector<int> order;
+        for(auto& r: ranked) {
+            order.push_back(r.second);
+        }
+        return order;
+    }
+
+    static void append(std::vector<int>& to, std::vector<int> const& from) {
+        to.insert(to.end(), from.begin(), from.end());
+    }
+
+    static std::vector<int> parseCpuList(std::string const& list) {
+        std::vector<int> cpus;
+        std::stringstream s(list);
+        std::string range;
+        while(std::getline(s, range, ',')) {
+            if(range.empty()) continue;
+            auto dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for(int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    static int readInt(std::string const& path, int def) {
+        std::ifstream f(path);
+        int value;
+        return f >> value ? value : def;
+    }
+
+private:
+    std::vector<Cpu> _cpus;
+    std::vector<int> _order;
+    std::string _policy;
+};
+
+/**
+ * Pins every benchmark thread in thread_init() according to --pin, before
+ * the wrapped implementation sets up its thread state.
+ */
+template<typename IMPL>
+class ImplPinned {
+public:
+
+    ImplPinned(IMPL& impl)
+    : _impl(impl)
+    {
+    }
+
+    void init(size_t bucketScale) {
+        _impl.init(bucketScale);
+    }
+
+    void thread_init(int tid) {
+        Topology::get().pin(tid);
+        _impl.thread_init(tid);
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    void insert(K const& k, V const& v) {
+        _impl.insert(k, v);
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    bool get(K const& k, V& v) {
+        return _impl.get(k, v);
+    }
+
+    void cleanup() {
+        _impl.cleanup();
+    }
+
+    std::string name() const {
+        return _impl.name();
+    }
+
+    void statsString(std::ostream& out, size_t bars) {
+        _impl.statsString(out, bars);
+    }
+
+    void finishPhase(std::string const& phase) {
+        endPhase(_impl, phase);
+    }
+
+private:
+    IMPL& _impl;
+};
+
+template<typename IMPL>
+void endPhase(ImplPinned<IMPL>& impl, std::string const& phase) {
+    impl.finishPhase(phase);
+}
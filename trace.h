@@ -0,0 +1,567 @@
+#pragma once
+
+// Operation traces: --record=file writes every insert() and get() a driver
+// issues to a trace, --mode=replay --trace=file feeds a trace to any table.
+//
+// A trace starts with a header (magic "HTTRACE", version, flags) followed by
+// chunks. A chunk holds consecutive operations of one thread:
+//   chunk:  u32 tid, u32 bytes, u64 records, then the records
+//   record: u8 op, u16 key length, u64 value, [u64 ns since the start if
+//           TIMESTAMPS is set], key bytes
+// All fields are little endian and unaligned. The ops are INSERT, GET_HIT
+// and GET_MISS (a get and whether it found its key), and PHASE, which the
+// recorder writes into every stream at the end of a phase, with the name of
+// the phase as its key. Keys are stored as the bytes key_accessor gives, so
+// integer keys take 8 bytes, strings their length.
+//
+// The replayer maps the trace, decodes the keys of every stream up front and
+// then runs the phases of the trace one after the other. Stream s is replayed
+// by thread s % --threads. Gets whose outcome differs from the recorded one
+// are counted as mismatches. With --replay_pace=1 every operation waits
+// until its recorded time, if the trace has timestamps
+// (--record_timestamps=1).
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <xmmintrin.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "driver.h"
+#include "key_accessor.h"
+#include "results.h"
+
+struct TraceFormat {
+    static constexpr char MAGIC[8] = {'H', 'T', 'T', 'R', 'A', 'C', 'E', '\0'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t TIMESTAMPS = 1;
+
+    enum Op: uint8_t {
+        INSERT,
+        GET_HIT,
+        GET_MISS,
+        PHASE,
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+    };
+
+    struct ChunkHeader {
+        uint32_t tid;
+        uint32_t bytes;
+        uint64_t records;
+    };
+
+    static size_t recordSize(size_t keyLength, bool timestamps) {
+        return 1 + 2 + 8 + (timestamps ? 8 : 0) + keyLength;
+    }
+
+    template<typename V>
+    static uint64_t valueOf(V const& v, typename std::enable_if<std::is_integral<V>::value>::type* = nullptr) {
+        return (uint64_t)v;
+    }
+
+    template<typename V>
+    static uint64_t valueOf(V const& v, typename std::enable_if<!std::is_integral<V>::value>::type* = nullptr) {
+        return 0;
+    }
+};
+
+constexpr char TraceFormat::MAGIC[8];
+
+/**
+ * Appends chunks to a trace file. Threads buffer their records and hand in
+ * whole chunks, so the file lock is only taken once per chunk.
+ */
+class TraceWriter {
+public:
+
+    TraceWriter(std::string const& path, bool timestamps)
+    : _file(fopen(path.c_str(), "wb"))
+    , _timestamps(timestamps)
+    {
+        if(!_file) {
+            std::cerr << "Trace: cannot write " << path << std::endl;
+            return;
+        }
+        TraceFormat::Header header;
+        memcpy(header.magic, TraceFormat::MAGIC, sizeof(header.magic));
+        header.version = TraceFormat::VERSION;
+        header.flags = timestamps ? TraceFormat::TIMESTAMPS : 0;
+        fwrite(&header, sizeof(header), 1, _file);
+    }
+
+    TraceWriter(TraceWriter const&) = delete;
+    TraceWriter& operator=(TraceWriter const&) = delete;
+
+    ~TraceWriter() {
+        if(_file) fclose(_file);
+    }
+
+    bool timestamps() const {
+        return _timestamps;
+    }
+
+    void writeChunk(uint32_t tid, std::vector<char> const& records, uint64_t count) {
+        if(!_file || records.empty()) return;
+        TraceFormat::ChunkHeader chunk{tid, (uint32_t)records.size(), count};
+        std::lock_guard<std::mutex> lock(_lock);
+        fwrite(&chunk, sizeof(chunk), 1, _file);
+        fwrite(records.data(), records.size(), 1, _file);
+    }
+
+private:
+    FILE* _file;
+    bool _timestamps;
+    std::mutex _lock;
+};
+
+/**
+ * Records every insert() and get() passed to the wrapped implementation,
+ * enabled with --record=file.
+ */
+template<typename IMPL>
+class ImplTrace {
+public:
+
+    // Chunks are written when a thread buffered this many bytes
+    static constexpr size_t CHUNK_BYTES = 1 << 20;
+
+    struct alignas(64) ThreadTrace {
+        std::vector<char> buffer;
+        uint64_t records = 0;
+    };
+
+    ImplTrace(IMPL& impl)
+    : _impl(impl)
+    , _writer(Settings::global()["record"].asString(), Settings::global()["record_timestamps"].asUnsignedValue())
+    , _start(std::chrono::steady_clock::now())
+    , _threads(Settings::global()["threads"].asUnsignedValue())
+    {
+    }
+
+    ~ImplTrace() {
+        flush();
+    }
+
+    void init(size_t bucketScale) {
+        _impl.init(bucketScale);
+    }
+
+    void thread_init(int tid) {
+        _tid = tid;
+        _impl.thread_init(tid);
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    void insert(K const& k, V const& v) {
+        _impl.insert(k, v);
+        append(TraceFormat::INSERT, hashtables::key_accessor<K>::data(k), hashtables::key_accessor<K>::size(k), TraceFormat::valueOf(v));
+    }
+
+    template<typename K, typename V>
+    __attribute__((always_inline))
+    bool get(K const& k, V& v) {
+        bool found = _impl.get(k, v);
+        append(found ? TraceFormat::GET_HIT : TraceFormat::GET_MISS, hashtables::key_accessor<K>::data(k), hashtables::key_accessor<K>::size(k), found ? TraceFormat::valueOf(v) : 0);
+        return found;
+    }
+
+    void cleanup() {
+        _impl.cleanup();
+    }
+
+    std::string name() const {
+        return _impl.name();
+    }
+
+    void statsString(std::ostream& out, size_t bars) {
+        _impl.statsString(out, bars);
+    }
+
+    /**
+     * Marks the end of the phase in every stream and writes out all buffers.
+     * The driver has joined its threads at this point.
+     */
+    void finishPhase(std::string const& phase) {
+        for(size_t tid = 0; tid < _threads.size(); ++tid) {
+            appendTo(_threads[tid], TraceFormat::PHASE, phase.data(), phase.size(), 0);
+        }
+        flush();
+        endPhase(_impl, phase);
+    }
+
+private:
+
+    void flush() {
+        for(size_t tid = 0; tid < _threads.size(); ++tid) {
+            ThreadTrace& t = _threads[tid];
+            _writer.writeChunk(tid, t.buffer, t.records);
+            t.buffer.clear();
+            t.records = 0;
+        }
+    }
+
+    __attribute__((always_inline))
+    void append(uint8_t op, char const* key, size_t length, uint64_t value) {
+        ThreadTrace& t = _threads[_tid];
+        appendTo(t, op, key, length, value);
+        if(t.buffer.size() >= CHUNK_BYTES) {
+            _writer.writeChunk(_tid, t.buffer, t.records);
+            t.buffer.clear();
+            t.records = 0;
+        }
+    }
+
+    void appendTo(ThreadTrace& t, uint8_t op, char const* key, size_t length, uint64_t value) {
+        uint16_t keyLength = (uint16_t)std::min<size_t>(length, UINT16_MAX);
+        size_t at = t.buffer.size();
+        t.buffer.resize(at + TraceFormat::recordSize(keyLength, _writer.timestamps()));
+        char* p = t.buffer.data() + at;
+        *p++ = (char)op;
+        memcpy(p, &keyLength, 2); p += 2;
+        memcpy(p, &value, 8); p += 8;
+        if(_writer.timestamps()) {
+            uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+            memcpy(p, &ns, 8); p += 8;
+        }
+        memcpy(p, key, keyLength);
+        t.records++;
+    }
+
+private:
+    IMPL& _impl;
+    TraceWriter _writer;
+    std::chrono::steady_clock::time_point _start;
+    std::vector<ThreadTrace> _threads;
+    static __thread int _tid;
+};
+
+template<typename IMPL>
+__thread int ImplTrace<IMPL>::_tid;
+
+template<typename IMPL>
+void endPhase(ImplTrace<IMPL>& impl, std::string const& phase) {
+    impl.finishPhase(phase);
+}
+
+/**
+ * Builds a key from the bytes in a trace: a malloc'd copy handed to the
+ * (char*, length) constructor of string keys, plain copies otherwise. Keys
+ * that do not own their bytes, like my_string_ref, keep their copy until the
+ * process exits.
+ */
+template<typename K, bool TRIVIAL = !std::is_constructible<K, char*, size_t>::value>
+struct TraceKey {
+    static void append(std::vector<K>& keys, char const* data, size_t length) {
+        keys.emplace_back();
+        memcpy((void*)&keys.back(), data, std::min(length, sizeof(K)));
+    }
+};
+
+template<typename K>
+struct TraceKey<K, false> {
+    static void append(std::vector<K>& keys, char const* data, size_t length) {
+        char* s = (char*)malloc(length + 1);
+        memcpy(s, data, length);
+        s[length] = '\0';
+        keys.emplace_back(s, length);
+    }
+};
+
+/**
+ * Maps a trace and splits it into streams of records, one per recorded
+ * thread.
+ */
+class TraceReader {
+public:
+
+    struct Record {
+        uint8_t op;
+        uint16_t keyLength;
+        uint64_t value;
+        uint64_t timestamp;
+        char const* key;
+    };
+
+    struct Stream {
+        std::vector<std::pair<char const*, uint64_t>> chunks;
+        size_t records = 0;
+    };
+
+    TraceReader(std::string const& path)
+    : _map(nullptr)
+    , _size(0)
+    , _timestamps(false)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if(fd < 0 || fstat(fd, &st) || (size_t)st.st_size < sizeof(TraceFormat::Header)) {
+            std::cerr << "Trace: cannot read " << path << std::endl;
+            if(fd >= 0) close(fd);
+            return;
+        }
+        _size = st.st_size;
+        void* map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(map == MAP_FAILED) {
+            std::cerr << "Trace: cannot map " << path << std::endl;
+            return;
+        }
+        _map = (char const*)map;
+        madvise((void*)_map, _size, MADV_SEQUENTIAL);
+
+        TraceFormat::Header header;
+        memcpy(&header, _map, sizeof(header));
+        if(memcmp(header.magic, TraceFormat::MAGIC, sizeof(header.magic)) || header.version != TraceFormat::VERSION) {
+            std::cerr << "Trace: " << path << " is not a trace of version " << TraceFormat::VERSION << std::endl;
+            return;
+        }
+        _timestamps = header.flags & TraceFormat::TIMESTAMPS;
+
+        char const* p = _map + sizeof(header);
+        char const* end = _map + _size;
+        while(p + sizeof(TraceFormat::ChunkHeader) <= end) {
+            TraceFormat::ChunkHeader chunk;
+            memcpy(&chunk, p, sizeof(chunk));
+            p += sizeof(chunk);
+            if(p + chunk.bytes > end) break;
+            if(chunk.tid >= _streams.size()) _streams.resize(chunk.tid + 1);
+            _streams[chunk.tid].chunks.emplace_back(p, chunk.records);
+            _streams[chunk.tid].records += chunk.records;
+            p += chunk.bytes;
+        }
+    }
+
+    TraceReader(TraceReader const&) = delete;
+    TraceReader& operator=(TraceReader const&) = delete;
+
+    ~TraceReader() {
+        if(_map) munmap((void*)_map, _size);
+    }
+
+    bool timestamps() const {
+        return _timestamps;
+    }
+
+    std::vector<Stream> const& streams() const {
+        return _streams;
+    }
+
+    /**
+     * Calls f(record) for every record of the stream, in order.
+     */
+    template<typename F>
+    void forEach(Stream const& stream, F&& f) const {
+        for(auto& chunk: stream.chunks) {
+            char const* p = chunk.first;
+            for(uint64_t r = 0; r < chunk.second; ++r) {
+                Record record;
+                record.op = (uint8_t)*p++;
+                memcpy(&record.keyLength, p, 2); p += 2;
+                memcpy(&record.value, p, 8); p += 8;
+                record.timestamp = 0;
+                if(_timestamps) {
+                    memcpy(&record.timestamp, p, 8); p += 8;
+                }
+                record.key = p;
+                p += record.keyLength;
+                f(record);
+            }
+        }
+    }
+
+private:
+    char const* _map;
+    size_t _size;
+    bool _timestamps;
+    std::vector<Stream> _streams;
+};
+
+/**
+ * Replays --trace on impl, see the top of this file.
+ */
+template<typename TEST, typename IMPL>
+class ReplayTest {
+public:
+
+    using K = typename TEST::key_type;
+    using V = typename TEST::value_type;
+
+    struct Op {
+        uint8_t op;
+        uint64_t value;
+        uint64_t timestamp;
+    };
+
+    struct StreamOps {
+        std::vector<Op> ops;
+        std::vector<K> keys;            // key of ops[i], PHASE ops have none
+        std::vector<size_t> phaseEnds;  // index of every PHASE op
+    };
+
+    struct alignas(64) ThreadResult {
+        size_t ops = 0;
+        size_t mismatches = 0;
+    };
+
+    ReplayTest(TEST& test, IMPL& impl)
+    : _test(test)
+    , _impl(impl)
+    {
+    }
+
+    void test() {
+        Settings& settings = Settings::global();
+        size_t bucketScale = settings["buckets_scale"].asUnsignedValue();
+        size_t threads = settings["threads"].asUnsignedValue();
+        bool pace = settings["replay_pace"].asUnsignedValue();
+        TraceReader reader(settings["trace"].asString());
+        if(reader.streams().empty()) {
+            std::cerr << "Trace: nothing to replay" << std::endl;
+            return;
+        }
+        pace = pace && reader.timestamps();
+
+        std::vector<StreamOps> streams(reader.streams().size());
+        std::vector<std::string> phases;
+        decode(reader, streams, phases);
+
+        Timer timer;
+        _impl.init(bucketScale);
+        double setupTime = timer.getElapsedSeconds();
+
+        std::vector<size_t> position(streams.size(), 0);
+        for(size_t phase = 0; phase < phases.size(); ++phase) {
+            std::vector<ThreadResult> results(threads);
+            double time = runThreads(threads, [this](size_t tid) { _impl.thread_init(tid); }, [&](size_t tid) {
+                auto start = std::chrono::steady_clock::now();
+                for(size_t s = tid; s < streams.size(); s += threads) {
+                    StreamOps& stream = streams[s];
+                    size_t end = phase < stream.phaseEnds.size() ? stream.phaseEnds[phase] : stream.ops.size();
+                    replay(stream, position[s], end, pace, start, results[tid]);
+                    position[s] = end + 1;
+                }
+            });
+            endPhase(_impl, phases[phase]);
+
+            ThreadResult total;
+            for(auto& r: results) {
+                total.ops += r.ops;
+                total.mismatches += r.mismatches;
+            }
+            printHeader();
+            std::cout << std::fixed << std::setw( 25 ) << _impl.name()
+                      << std::fixed << std::setw(  4 ) << threads
+                      << std::fixed << std::setw(  8 ) << streams.size()
+                      << std::fixed << std::setw( 12 ) << phases[phase]
+                      << std::fixed << std::setw( 11 ) << total.ops
+                      << std::fixed << std::setw(  7 ) << std::setprecision(3) << setupTime
+                      << std::fixed << std::setw(  8 ) << std::setprecision(3) << time
+                      << std::fixed << std::setw(  8 ) << std::setprecision(2) << total.ops / time / 1e6
+                      << std::fixed << std::setw( 10 ) << total.mismatches
+                      << std::endl;
+
+            std::string metric = "replay_" + Results::metricName(phases[phase]);
+            Results& r = Results::get();
+            r.set("time." + metric, time);
+            r.set("mops." + metric, total.ops / time / 1e6);
+            r.set("mismatches." + metric, total.mismatches);
+        }
+
+        _impl.cleanup();
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "ths"
+                  << std::fixed << std::setw(  8 ) << "streams"
+                  << std::fixed << std::setw( 12 ) << "phase"
+                  << std::fixed << std::setw( 11 ) << "ops"
+                  << std::fixed << std::setw(  7 ) << "setup"
+                  << std::fixed << std::setw(  8 ) << "time"
+                  << std::fixed << std::setw(  8 ) << "Mops"
+                  << std::fixed << std::setw( 10 ) << "mismatch"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+private:
+
+    /**
+     * Decodes the records of every stream into ops and keys, in parallel.
+     * The phase names are taken from the first stream that has PHASE ops; a
+     * trace without any is one phase called "replay".
+     */
+    static void decode(TraceReader const& reader, std::vector<StreamOps>& streams, std::vector<std::string>& phases) {
+        std::vector<std::vector<std::string>> names(streams.size());
+        runThreads(streams.size(), [](size_t) {}, [&](size_t s) {
+            TraceReader::Stream const& stream = reader.streams()[s];
+            StreamOps& out = streams[s];
+            out.ops.reserve(stream.records);
+            out.keys.reserve(stream.records);
+            reader.forEach(stream, [&](TraceReader::Record const& record) {
+                if(record.op == TraceFormat::PHASE) {
+                    out.phaseEnds.push_back(out.ops.size());
+                    names[s].emplace_back(record.key, record.keyLength);
+                    TraceKey<K>::append(out.keys, "", 0);
+                } else {
+                    TraceKey<K>::append(out.keys, record.key, record.keyLength);
+                }
+                out.ops.push_back(Op{record.op, record.value, record.timestamp});
+            });
+        });
+        for(auto& n: names) {
+            if(n.size() > phases.size()) phases = n;
+        }
+        bool trailing = false;
+        for(auto& s: streams) {
+            size_t last = s.phaseEnds.empty() ? 0 : s.phaseEnds.back() + 1;
+            trailing |= last < s.ops.size();
+        }
+        if(phases.empty() || trailing) phases.push_back("replay");
+    }
+
+    void replay(StreamOps& stream, size_t from, size_t to, bool pace, std::chrono::steady_clock::time_point start, ThreadResult& result) {
+        V v;
+        for(size_t i = from; i < to && i < stream.ops.size(); ++i) {
+            Op const& op = stream.ops[i];
+            if(pace) {
+                auto due = start + std::chrono::nanoseconds(op.timestamp - stream.ops[from].timestamp);
+                while(std::chrono::steady_clock::now() < due) _mm_pause();
+            }
+            if(op.op == TraceFormat::INSERT) {
+                _impl.insert(stream.keys[i], (V)op.value);
+            } else {
+                bool found = _impl.get(stream.keys[i], v);
+                result.mismatches += found != (op.op == TraceFormat::GET_HIT);
+            }
+            result.ops++;
+        }
+    }
+
+private:
+    TEST& _test;
+    IMPL& _impl;
+};
@@ -0,0 +1,353 @@
+#pragma once
+
+// YCSB-style mixed workload, selected with --mode=workload.
+//
+// Every thread owns the keys test.key(tid, 0..inserts). The load phase
+// inserts the first --load fraction of them, the run phase then issues
+// --operations operations per thread, drawn from the mix of --workload:
+//
+//   A: 50% read, 50% update        D: 95% read (latest), 5% insert
+//   B: 95% read,  5% update        E: 95% scan, 5% insert
+//   C: 100% read                   F: 50% read, 50% read-modify-write
+//   custom: --read, --update, --insert, --scan and --rmw proportions
+//
+// The tables have no overwrite, so an update is an insert of an existing
+// key, a read-modify-write is a get followed by that insert, and a scan is a
+// run of up to --scanlength gets of consecutive records. Inserts take the
+// thread's next fresh key; once those run out they turn into updates.
+// Records are chosen with --distribution=uniform|zipfian|latest (default
+// zipfian, latest for D, --theta for the skew). The stream of every thread
+// only depends on --seed and its tid, so runs are comparable across tables.
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "driver.h"
+#include "results.h"
+
+struct WorkloadMix {
+    enum Op {
+        READ,
+        UPDATE,
+        INSERT,
+        SCAN,
+        RMW,
+        OPS
+    };
+
+    static constexpr const char* opName(size_t op) {
+        return op == READ   ? "read"
+             : op == UPDATE ? "update"
+             : op == INSERT ? "insert"
+             : op == SCAN   ? "scan"
+             :                "rmw"
+             ;
+    }
+
+    enum Distribution {
+        UNIFORM,
+        ZIPFIAN,
+        LATEST,
+    };
+
+    std::string name;
+    double proportion[OPS];
+    Distribution distribution;
+
+    static WorkloadMix fromSettings() {
+        Settings& settings = Settings::global();
+        WorkloadMix mix;
+        mix.name = settings["workload"].asString();
+        if(mix.name.empty()) mix.name = "A";
+        mix.distribution = ZIPFIAN;
+        for(double& p: mix.proportion) p = 0.0;
+        if(mix.name == "A") {
+            mix.proportion[READ] = 0.5; mix.proportion[UPDATE] = 0.5;
+        } else if(mix.name == "B") {
+            mix.proportion[READ] = 0.95; mix.proportion[UPDATE] = 0.05;
+        } else if(mix.name == "C") {
+            mix.proportion[READ] = 1.0;
+        } else if(mix.name == "D") {
+            mix.proportion[READ] = 0.95; mix.proportion[INSERT] = 0.05;
+            mix.distribution = LATEST;
+        } else if(mix.name == "E") {
+            mix.proportion[SCAN] = 0.95; mix.proportion[INSERT] = 0.05;
+        } else if(mix.name == "F") {
+            mix.proportion[READ] = 0.5; mix.proportion[RMW] = 0.5;
+        } else {
+            mix.name = "custom";
+            for(size_t op = 0; op < OPS; ++op) {
+                mix.proportion[op] = settingAsDouble(opName(op), 0.0);
+            }
+        }
+        std::string dist = settings["distribution"].asString();
+        if(dist == "uniform") mix.distribution = UNIFORM;
+        else if(dist == "zipfian") mix.distribution = ZIPFIAN;
+        else if(dist == "latest") mix.distribution = LATEST;
+
+        double total = 0.0;
+        for(double p: mix.proportion) total += p;
+        if(total <= 0.0) {
+            mix.proportion[READ] = total = 1.0;
+        }
+        for(double& p: mix.proportion) p /= total;
+        return mix;
+    }
+
+    __attribute__((always_inline))
+    Op pick(Random& rng) const {
+        double u = rng.nextDouble();
+        for(size_t op = 0; op < OPS-1; ++op) {
+            if(u < proportion[op]) return (Op)op;
+            u -= proportion[op];
+        }
+        return (Op)(OPS-1);
+    }
+};
+
+template<typename TEST, typename IMPL>
+class WorkloadTest {
+public:
+
+    using Op = WorkloadMix::Op;
+
+    struct alignas(64) ThreadStats {
+        size_t ops[WorkloadMix::OPS];
+        size_t found;
+        size_t reads;
+        size_t inserted;
+    };
+
+    WorkloadTest(TEST& test, IMPL& impl)
+    : _test(test)
+    , _impl(impl)
+    {
+    }
+
+    void test() {
+        readSettings();
+
+        Timer timer;
+        _impl.init(_bucketScale);
+        double setupTime = timer.getElapsedSeconds();
+
+        double loadTime = load();
+        endPhase(_impl, "load");
+
+        double runTime = runThreads(_threads, [this](size_t tid) { _impl.thread_init(tid); }, [this](size_t tid) {
+            run(tid);
+        });
+        endPhase(_impl, "run");
+
+        ThreadStats total = ThreadStats();
+        for(auto& s: _stats) {
+            for(size_t op = 0; op < WorkloadMix::OPS; ++op) total.ops[op] += s.ops[op];
+            total.found += s.found;
+            total.reads += s.reads;
+        }
+        size_t allOps = 0;
+        for(size_t op = 0; op < WorkloadMix::OPS; ++op) allOps += total.ops[op];
+
+        timer.reset();
+        _impl.cleanup();
+        double cleanupTime = timer.getElapsedSeconds();
+
+        printHeader();
+        std::cout << std::fixed << std::setw( 25 ) << _impl.name()
+                  << std::fixed << std::setw(  4 ) << _bucketScale
+                  << std::fixed << std::setw(  4 ) << _threads
+                  << std::fixed << std::setw(  7 ) << _mix.name
+                  << std::fixed << std::setw( 10 ) << allOps
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << setupTime
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << loadTime
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << runTime
+                  << std::fixed << std::setw(  8 ) << std::setprecision(2) << allOps / runTime / 1e6
+                  ;
+        for(size_t op = 0; op < WorkloadMix::OPS; ++op) {
+            std::cout << std::fixed << std::setw(  8 ) << std::setprecision(2) << total.ops[op] / runTime / 1e6;
+        }
+        std::cout << std::fixed << std::setw(  7 ) << std::setprecision(1) << (total.reads ? 100.0 * total.found / total.reads : 0.0)
+                  << std::fixed << std::setw(  7 ) << std::setprecision(3) << cleanupTime
+                  << std::endl;
+
+        Results& results = Results::get();
+        results.set("time.setup", setupTime);
+        results.set("time.load", loadTime);
+        results.set("time.run", runTime);
+        results.set("time.clean", cleanupTime);
+        results.set("mops.run", allOps / runTime / 1e6);
+        for(size_t op = 0; op < WorkloadMix::OPS; ++op) {
+            if(total.ops[op]) results.set(std::string("mops.") + WorkloadMix::opName(op), total.ops[op] / runTime / 1e6);
+        }
+        results.set("hitratio", total.reads ? (double)total.found / total.reads : 0.0);
+    }
+
+    static void printHeader() {
+        static bool printed = false;
+        if(printed) return;
+        printed = true;
+        std::cout << "\033[1m"
+                  << std::fixed << std::setw( 25 ) << "name"
+                  << std::fixed << std::setw(  4 ) << "scl"
+                  << std::fixed << std::setw(  4 ) << "ths"
+                  << std::fixed << std::setw(  7 ) << "wl"
+                  << std::fixed << std::setw( 10 ) << "ops"
+                  << std::fixed << std::setw(  7 ) << "setup"
+                  << std::fixed << std::setw(  7 ) << "load"
+                  << std::fixed << std::setw(  7 ) << "run"
+                  << std::fixed << std::setw(  8 ) << "Mops"
+                  ;
+        for(size_t op = 0; op < WorkloadMix::OPS; ++op) {
+            std::cout << std::fixed << std::setw(  8 ) << WorkloadMix::opName(op);
+        }
+        std::cout << std::fixed << std::setw(  7 ) << "hit%"
+                  << std::fixed << std::setw(  7 ) << "clean"
+                  << std::endl
+                  << "\033[0m"
+                  ;
+    }
+
+protected:
+
+    /**
+     * Reads the settings of the workload and sets up the test data.
+     */
+    void readSettings() {
+        Settings& settings = Settings::global();
+        _bucketScale = settings["buckets_scale"].asUnsignedValue();
+        _threads = settings["threads"].asUnsignedValue();
+        _inserts = settings["inserts"].asUnsignedValue();
+        _operations = settingAsUnsigned("operations", _inserts);
+        _scanLength = settingAsUnsigned("scanlength", 100);
+        _seed = settingAsUnsigned("seed", 1234567);
+        _mix = WorkloadMix::fromSettings();
+        _loaded = _inserts * std::min(1.0, std::max(0.0, settingAsDouble("load", 0.5)));
+        if(_loaded == 0) _loaded = 1;
+
+        _test.setup(_bucketScale, _threads, _inserts, settingAsDouble("duplicateratio", 0.0), settingAsDouble("collisionratio", 1.0));
+
+        _zipf.reset(new ZipfianGenerator(std::max<size_t>(2, _mix.distribution == WorkloadMix::LATEST ? _loaded : _loaded * _threads), settingAsDouble("theta", 0.99), _threads));
+    }
+
+    /**
+     * Inserts the first _loaded keys of every thread and resets the counters.
+     */
+    double load() {
+        _stats.assign(_threads, ThreadStats());
+        return runThreads(_threads, [this](size_t tid) { _impl.thread_init(tid); }, [this](size_t tid) {
+            for(size_t i = 0; i < _loaded; ++i) {
+                auto const& k = _test.key(tid, i);
+                _impl.insert(k, _test.value(tid, i, k));
+            }
+        });
+    }
+
+    /**
+     * Picks an existing record (thread, index). Other threads' records are
+     * limited to the preloaded ones, so the choice never depends on timing.
+     */
+    __attribute__((always_inline))
+    void chooseRecord(size_t tid, Random& rng, size_t& rtid, size_t& ri) {
+        ThreadStats& stats = _stats[tid];
+        switch(_mix.distribution) {
+            case WorkloadMix::UNIFORM: {
+                size_t r = rng.nextBelow(_loaded * _threads);
+                rtid = r % _threads;
+                ri = r / _threads;
+                break;
+            }
+            case WorkloadMix::ZIPFIAN: {
+                size_t r = _zipf->next(rng);
+                rtid = r % _threads;
+                ri = r / _threads;
+                break;
+            }
+            case WorkloadMix::LATEST: {
+                size_t newest = _loaded + stats.inserted - 1;
+                size_t back = _zipf->next(rng);
+                rtid = tid;
+                ri = back <= newest ? newest - back : 0;
+                break;
+            }
+        }
+    }
+
+    void run(size_t tid) {
+        Random rng(Random::seedFor(_seed, tid));
+        for(size_t n = 0; n < _operations; ++n) {
+            step(tid, rng);
+        }
+    }
+
+    /**
+     * Picks the next operation of thread tid and executes it.
+     */
+    __attribute__((always_inline))
+    void step(size_t tid, Random& rng) {
+        ThreadStats& stats = _stats[tid];
+        typename TEST::value_type v;
+        size_t rtid = 0;
+        size_t ri = 0;
+
+        Op op = _mix.pick(rng);
+        if(op == WorkloadMix::INSERT && _loaded + stats.inserted >= _inserts) {
+            op = WorkloadMix::UPDATE;
+        }
+        switch(op) {
+            case WorkloadMix::READ: {
+                chooseRecord(tid, rng, rtid, ri);
+                stats.found += _impl.get(_test.key(rtid, ri), v);
+                stats.reads++;
+                break;
+            }
+            case WorkloadMix::UPDATE: {
+                chooseRecord(tid, rng, rtid, ri);
+                auto const& k = _test.key(rtid, ri);
+                _impl.insert(k, _test.value(rtid, ri, k));
+                break;
+            }
+            case WorkloadMix::INSERT: {
+                size_t i = _loaded + stats.inserted++;
+                auto const& k = _test.key(tid, i);
+                _impl.insert(k, _test.value(tid, i, k));
+                break;
+            }
+            case WorkloadMix::SCAN: {
+                chooseRecord(tid, rng, rtid, ri);
+                size_t length = 1 + rng.nextBelow(_scanLength);
+                size_t limit = rtid == tid ? _loaded + stats.inserted : _loaded;
+                for(size_t i = ri; i < ri + length && i < limit; ++i) {
+                    stats.found += _impl.get(_test.key(rtid, i), v);
+                    stats.reads++;
+                }
+                break;
+            }
+            case WorkloadMix::RMW: {
+                chooseRecord(tid, rng, rtid, ri);
+                auto const& k = _test.key(rtid, ri);
+                stats.found += _impl.get(k, v);
+                stats.reads++;
+                _impl.insert(k, _test.value(rtid, ri, k));
+                break;
+            }
+            default:
+                break;
+        }
+        stats.ops[op]++;
+    }
+
+protected:
+    TEST& _test;
+    IMPL& _impl;
+    WorkloadMix _mix;
+    std::unique_ptr<ZipfianGenerator> _zipf;
+    std::vector<ThreadStats> _stats;
+    size_t _bucketScale;
+    size_t _threads;
+    size_t _inserts;
+    size_t _operations;
+    size_t _scanLength;
+    size_t _loaded;
+    uint64_t _seed;
+};
@@ -802,10 +802,14 @@ public:
     using key_type = K;
     using value_type = V;
 
+    /**
+     * Starts at 2^--initial_scale elements (default --buckets_scale), as
+     * ImplInsituUGrow does.
+     */
     __attribute__((always_inline))
     void init(size_t bucketScale) {
         // Size of key is in number of ints
-        map = new map_type(1 << bucketScale);
+        map = new map_type(1 << settingAsUnsigned("initial_scale", bucketScale));
     }
 
     __attribute__((always_inline))